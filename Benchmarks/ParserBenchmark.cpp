@@ -0,0 +1,209 @@
+// Parser benchmark
+//
+// Feeds synthetic serial streams through MidiStreamParser and the note
+// transform (BridgeConfig), the serial -> MIDI path of the bridge minus the
+// ports, and reports throughput. Links hairless_core only: no window, no
+// MIDI devices, so it runs on headless build machines.
+//
+//   hairless_parser_bench [--megabytes <n>] [--chunk <bytes>] [--no-transform]
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "BridgeConfig.h"
+#include "MidiStreamParser.h"
+#include "NoteStateTracker.h"
+
+#include <cstdio>
+#include <cstring>
+
+struct BenchmarkOptions
+{
+    int megabytes = 64;
+    int chunkSize = 256;        // bytes per parse() call, like a serial read
+    bool transform = true;
+};
+
+static void printUsage(const char* argv0)
+{
+    std::fprintf(stderr, "Usage: %s [--megabytes <n>] [--chunk <bytes>] [--no-transform]\n", argv0);
+}
+
+static bool parseArguments(int argc, char** argv, BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--megabytes") == 0 && hasValue)
+            options.megabytes = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--chunk") == 0 && hasValue)
+            options.chunkSize = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--no-transform") == 0)
+            options.transform = false;
+        else
+            return false;
+    }
+
+    return options.megabytes > 0 && options.chunkSize > 0;
+}
+
+//==============================================================================
+// One second or so of typical traffic for each pattern, repeated to size
+static void appendNotes(juce::MemoryBlock& stream, juce::Random& random)
+{
+    // Six strings, note on then off with running status
+    for (int i = 0; i < 512; ++i)
+    {
+        const juce::uint8 channel = (juce::uint8) random.nextInt(6);
+        const juce::uint8 note = (juce::uint8) (40 + random.nextInt(40));
+        const juce::uint8 bytes[] = { (juce::uint8) (0x90 | channel), note, (juce::uint8) (1 + random.nextInt(127)), note, 0 };
+        stream.append(bytes, sizeof(bytes));
+    }
+}
+
+static void appendMixed(juce::MemoryBlock& stream, juce::Random& random)
+{
+    // Notes, pitch bend and controllers with MIDI clock in between
+    for (int i = 0; i < 512; ++i)
+    {
+        const juce::uint8 channel = (juce::uint8) random.nextInt(6);
+
+        switch (random.nextInt(4))
+        {
+            case 0:
+            {
+                const juce::uint8 bytes[] = { (juce::uint8) (0x90 | channel), (juce::uint8) (40 + random.nextInt(40)), 100 };
+                stream.append(bytes, sizeof(bytes));
+                break;
+            }
+            case 1:
+            {
+                const juce::uint8 bytes[] = { (juce::uint8) (0xE0 | channel), (juce::uint8) random.nextInt(128), 0xF8, (juce::uint8) random.nextInt(128) };
+                stream.append(bytes, sizeof(bytes));
+                break;
+            }
+            case 2:
+            {
+                const juce::uint8 bytes[] = { (juce::uint8) (0xB0 | channel), 1, (juce::uint8) random.nextInt(128) };
+                stream.append(bytes, sizeof(bytes));
+                break;
+            }
+            default:
+            {
+                const juce::uint8 bytes[] = { (juce::uint8) (0x80 | channel), (juce::uint8) (40 + random.nextInt(40)), 0 };
+                stream.append(bytes, sizeof(bytes));
+                break;
+            }
+        }
+    }
+}
+
+static void appendSysEx(juce::MemoryBlock& stream, juce::Random& random)
+{
+    // Patch dumps
+    for (int i = 0; i < 4; ++i)
+    {
+        const juce::uint8 start[] = { 0xF0, 0x7D };
+        stream.append(start, sizeof(start));
+
+        for (int j = 0; j < 1000; ++j)
+        {
+            const juce::uint8 data = (juce::uint8) random.nextInt(128);
+            stream.append(&data, 1);
+        }
+
+        const juce::uint8 end = 0xF7;
+        stream.append(&end, 1);
+    }
+}
+
+static juce::MemoryBlock makeStream(void (*appendPattern)(juce::MemoryBlock&, juce::Random&), size_t numBytes)
+{
+    juce::MemoryBlock stream;
+    juce::Random random(1234);
+
+    while (stream.getSize() < numBytes)
+        appendPattern(stream, random);
+
+    return stream;
+}
+
+//==============================================================================
+struct BenchmarkResult
+{
+    double seconds = 0.0;
+    juce::uint64 messages = 0;
+    juce::uint64 sent = 0;
+};
+
+static BenchmarkResult runStream(const juce::MemoryBlock& stream, const BenchmarkOptions& options)
+{
+    // A scale filter with replacement, the most table work per note
+    BridgeConfig config;
+    for (int pc = 0; pc < 12; ++pc)
+        config.diatonicMask[pc] = (0xAB5 >> pc) & 1; // C major
+    config.filterEnabled = true;
+    config.diatonicMode = BridgeConfig::DiatonicMode::ReplaceUp;
+    config.compile();
+
+    NoteStateTracker noteStates;
+    MidiStreamParser parser;
+    BenchmarkResult result;
+
+    parser.onMessage = [&](const juce::uint8* data, int size)
+    {
+        ++result.messages;
+
+        if (options.transform)
+        {
+            juce::MidiMessage transformed;
+            if (config.transform(noteStates, juce::MidiMessage(data, size, 0.0), transformed))
+                ++result.sent;
+        }
+    };
+
+    parser.onRealtimeMessage = [&](juce::uint8) { ++result.messages; };
+
+    const auto* data = static_cast<const juce::uint8*>(stream.getData());
+    const int size = (int) stream.getSize();
+
+    const juce::int64 startTicks = juce::Time::getHighResolutionTicks();
+
+    for (int offset = 0; offset < size; offset += options.chunkSize)
+        parser.parse(data + offset, juce::jmin(options.chunkSize, size - offset));
+
+    result.seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    if (! parseArguments(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    struct Pattern { const char* name; void (*append)(juce::MemoryBlock&, juce::Random&); };
+    const Pattern patterns[] = { { "notes", appendNotes }, { "mixed", appendMixed }, { "sysex", appendSysEx } };
+
+    std::printf("Scanner: %s, %d MB per stream, %d-byte reads, transform %s\n",
+                MidiStreamParser().getScannerName(), options.megabytes, options.chunkSize,
+                options.transform ? "on" : "off");
+
+    for (auto& pattern : patterns)
+    {
+        const juce::MemoryBlock stream = makeStream(pattern.append, (size_t) options.megabytes * 1024 * 1024);
+        const BenchmarkResult result = runStream(stream, options);
+        const double megabytes = (double) stream.getSize() / (1024.0 * 1024.0);
+
+        std::printf("  %-6s %8.1f MB/s %8.2f M msgs/s %7.1f ns/msg  (%llu messages, %llu sent)\n",
+                    pattern.name, megabytes / result.seconds, (double) result.messages / result.seconds / 1.0e6,
+                    result.messages > 0 ? result.seconds * 1.0e9 / (double) result.messages : 0.0,
+                    (unsigned long long) result.messages, (unsigned long long) result.sent);
+    }
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "BridgeConfig.h"
+
+BridgeConfig::BridgeConfig()
+{
+    // Defaults: all velocity scales at 10 (unity)
+    for (int i = 0; i < 6; ++i)
+    {
+        stringVelocityScale[i] = 10;
+        octaveShift[i] = 0;
+        semitoneShift[i] = 0;
+    }
+    for (int i = 0; i < 12; ++i)
+        diatonicMask[i] = true; // initially allow all notes (chromatic)
+    
+    compile();
+}
+
+void BridgeConfig::compile()
+{
+    for (int channel0 = 0; channel0 < 16; ++channel0)
+    {
+        // Channels 0..5 are the guitar strings; the rest only get the global shift
+        int shift = globalOctaveShift * 12;
+        if (channel0 < 6)
+            shift += (octaveShift[channel0] * 12) + semitoneShift[channel0];
+        
+        for (int note = 0; note < 128; ++note)
+        {
+            const int shifted = juce::jlimit(0, 127, note + shift);
+            int mapped = shifted;
+            
+            if (shouldFilterOutNote(shifted))
+            {
+                // Replace with next higher diatonic pitch class within MIDI range,
+                // or drop if there is none
+                mapped = noteDropped;
+                if (diatonicMode == DiatonicMode::ReplaceUp)
+                {
+                    for (int candidate = shifted + 1; candidate <= juce::jmin(127, shifted + 12); ++candidate)
+                    {
+                        if (diatonicMask[candidate % 12]) { mapped = candidate; break; }
+                    }
+                }
+            }
+            
+            noteOnTable[channel0][note] = (juce::uint8) mapped;
+            noteOffTable[channel0][note] = (juce::uint8) shifted;
+            velocityTable[channel0][note] = (juce::uint8) applyVelocityScaling(channel0, note);
+        }
+    }
+}
+
+bool BridgeConfig::transform(NoteStateTracker& noteStates, const juce::MidiMessage& original, juce::MidiMessage& transformed) const
+{
+    int originalChannel0 = original.getChannel() - 1;
+    int outChannel0 = unifiedChannel - 1;
+
+    if (original.isNoteOn())
+    {
+        const int note = original.getNoteNumber();
+        const juce::uint8 mapped = noteOnTable[originalChannel0][note];
+
+        if (mapped == noteDropped)
+        {
+            // Mark suppressed so matching NoteOff also filtered
+            noteStates.noteSuppressed(originalChannel0, note);
+            return false;
+        }
+
+        noteStates.noteOn(originalChannel0, note, outChannel0, mapped);
+
+        transformed = juce::MidiMessage::noteOn(outChannel0 + 1, mapped, velocityTable[originalChannel0][original.getVelocity()]);
+        transformed.setTimeStamp(original.getTimeStamp());
+        return true;
+    }
+    else if (original.isNoteOff())
+    {
+        // Whatever its NoteOn turned into, even if the settings have
+        // changed since; the current mapping only for notes never seen
+        const int note = original.getNoteNumber();
+        int mappedChannel0 = outChannel0;
+        int mapped = noteOffTable[originalChannel0][note];
+
+        if (noteStates.noteOff(originalChannel0, note, mappedChannel0, mapped) == NoteStateTracker::Release::suppressed)
+            return false; // Drop matching note-off
+
+        transformed = juce::MidiMessage::noteOff(mappedChannel0 + 1, mapped);
+        transformed.setTimeStamp(original.getTimeStamp());
+        return true;
+    }
+    else
+    {
+        // Non-note messages pass through unchanged
+        transformed = original;
+        if (original.isProgramChange() || original.isController() || original.isAftertouch() || original.isPitchWheel())
+            transformed.setChannel(outChannel0 + 1);
+        return true;
+    }
+}
+
+bool BridgeConfig::shouldFilterOutNote(int midiNote) const
+{
+    if (! filterEnabled) return false;
+    int pc = ((midiNote % 12) + 12) % 12;
+    return ! diatonicMask[pc];
+}
+
+int BridgeConfig::applyVelocityScaling(int channel, int velocity) const
+{
+    // Assume channels 0..5 map to guitar strings lowE..highE or vice versa.
+    // We cannot know pickup ordering; user can adjust scales accordingly.
+    if (channel >= 0 && channel < 6)
+    {
+        float factor = stringVelocityScale[channel] / 10.0f; // 1..10 -> 0.1..1.0
+        int scaled = (int)std::round(velocity * factor);
+        return juce::jlimit(1, 127, scaled); // avoid zero (interpreted as NoteOff)
+    }
+    return velocity;
+}
+
+juce::String BridgeConfig::getScaleDescription() const
+{
+    static const char* names[] = {"C","C#","D","D#","E","F","F#","G","G#","A","A#","B"};
+    juce::String allowed;
+    for (int i = 0; i < 12; ++i)
+        if (diatonicMask[i]) allowed << names[i] << " ";
+    return juce::String(names[rootNotePc]) + " scale: " + allowed.trim();
+}
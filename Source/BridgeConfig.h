@@ -0,0 +1,48 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "NoteStateTracker.h"
+
+/**
+ * BridgeConfig holds the note transform settings (string shifts, velocity
+ * scales, scale filter, output channel) and the lookup tables compiled from
+ * them. MidiSerialBridge publishes a new snapshot whenever a setting
+ * changes; once published, a snapshot is never modified, so the MIDI and
+ * serial threads can read it without locks.
+ */
+struct BridgeConfig
+{
+    enum class DiatonicMode { Off = 0, Filter = 1, ReplaceUp = 2 };
+    
+    BridgeConfig();
+    
+    // Settings -------------------------------------------------------------
+    int stringVelocityScale[6]; // 1..10 values, mapped to velocity multiplier
+    int octaveShift[6]; // -4..+4 per string
+    int semitoneShift[6]; // -12..12 per string
+    int unifiedChannel = 1; // 1..16 single channel output
+    int globalOctaveShift = 0; // -4..+4 applied to all strings
+    int rootNotePc = 0; // 0..11
+    bool diatonicMask[12]; // allowed pitch classes
+    bool filterEnabled = false;
+    DiatonicMode diatonicMode = DiatonicMode::Filter;
+    
+    // Compiled per input channel and note (or velocity), so the transform
+    // is a couple of table loads. Filled in by compile().
+    static constexpr juce::uint8 noteDropped = 0xFF;
+    juce::uint8 noteOnTable[16][128];   // shifted, filtered/replaced note, or noteDropped
+    juce::uint8 noteOffTable[16][128];  // shifted note
+    juce::uint8 velocityTable[16][128];
+    
+    void compile();
+    
+    // Map one outgoing message through the tables. Note Offs follow what
+    // their Note On became, as recorded in noteStates. Returns false if the
+    // message is filtered out.
+    bool transform(NoteStateTracker& noteStates, const juce::MidiMessage& original, juce::MidiMessage& transformed) const;
+    
+    bool shouldFilterOutNote(int midiNote) const; // returns true if note should be suppressed
+    int applyVelocityScaling(int channel, int velocity) const;
+    juce::String getScaleDescription() const;
+};
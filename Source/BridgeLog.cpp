@@ -0,0 +1,70 @@
+#include "BridgeLog.h"
+
+BridgeLog::BridgeLog(int requestedCapacity)
+    : capacity((juce::uint32) juce::nextPowerOfTwo(juce::jmax(2, requestedCapacity))),
+      slots(new Slot[capacity])
+{
+    // Each slot's sequence says whose turn it is: equal to a producer's
+    // position when free, position + 1 once written
+    for (juce::uint32 i = 0; i < capacity; ++i)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool BridgeLog::push(Event event, double timeMs, const juce::uint8* data, int length, juce::uint8 flags)
+{
+    juce::uint32 position = enqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    
+    for (;;)
+    {
+        slot = &slots[position & (capacity - 1)];
+        const auto difference = (juce::int32) (slot->sequence.load(std::memory_order_acquire) - position);
+        
+        if (difference == 0)
+        {
+            // Free: claim it, or retry from wherever the other producer left us
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            // Not consumed yet: full
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    
+    auto& record = slot->record;
+    record.timeMs = timeMs;
+    record.length = length;
+    record.event = event;
+    record.flags = flags;
+    record.numBytes = (juce::uint8) juce::jlimit(0, maxBytes, length);
+    
+    if (data != nullptr && record.numBytes > 0)
+        memcpy(record.bytes, data, record.numBytes);
+    else
+        record.numBytes = 0;
+    
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool BridgeLog::pop(Record& record)
+{
+    Slot& slot = slots[dequeuePosition & (capacity - 1)];
+    
+    if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+        return false;
+    
+    record = slot.record;
+    
+    // Hand the slot to the producer one lap ahead
+    slot.sequence.store(dequeuePosition + capacity, std::memory_order_release);
+    ++dequeuePosition;
+    return true;
+}
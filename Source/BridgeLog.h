@@ -0,0 +1,62 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/**
+ * BridgeLog is a fixed-size queue of binary debug records. The MIDI and
+ * serial threads push what they saw (event, arrival time, raw bytes) and
+ * move on; turning the record into text is left to whoever drains the
+ * queue, so debug logging costs the I/O threads a copy of a few bytes
+ * instead of string formatting.
+ *
+ * Any number of threads may push(); push() never blocks or allocates, and
+ * drops the record when the queue is full. Only one thread may pop().
+ */
+class BridgeLog
+{
+public:
+    enum class Event : juce::uint8
+    {
+        midiIn,             // message from the MIDI input
+        midiInSysEx,        // complete SysEx from the MIDI input (length only)
+        serialIn,           // message parsed from the serial port
+        serialSysExChunk    // streamed SysEx chunk from the serial port (length only)
+    };
+    
+    static constexpr int maxBytes = 17;
+    
+    struct Record
+    {
+        double timeMs;          // getMillisecondCounterHiRes clock
+        int length;             // full message length; only the first numBytes are kept
+        Event event;
+        juce::uint8 flags;      // event-specific, e.g. last SysEx chunk
+        juce::uint8 numBytes;
+        juce::uint8 bytes[maxBytes];
+    };
+    
+    explicit BridgeLog(int capacity = 4096);
+    
+    // Returns false (and counts a drop) if the queue is full
+    bool push(Event event, double timeMs, const juce::uint8* data, int length, juce::uint8 flags = 0);
+    
+    // Consumer only: take the oldest record
+    bool pop(Record& record);
+    
+    juce::uint64 getNumDropped() const { return numDropped.load(std::memory_order_relaxed); }
+    
+private:
+    struct Slot
+    {
+        std::atomic<juce::uint32> sequence;
+        Record record;
+    };
+    
+    const juce::uint32 capacity;    // power of two
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<juce::uint32> enqueuePosition { 0 };
+    alignas(64) juce::uint32 dequeuePosition = 0;
+    std::atomic<juce::uint64> numDropped { 0 };
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BridgeLog)
+};
@@ -0,0 +1,132 @@
+#include "CaptureReader.h"
+
+CaptureReader::CaptureReader()
+{
+}
+
+bool CaptureReader::open(const juce::File& file, juce::String& errorMessage)
+{
+    close();
+    
+    auto newMap = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    const auto fileSize = static_cast<juce::int64>(newMap->getSize());
+    
+    if (newMap->getData() == nullptr || fileSize < TrafficCapture::dataOffset)
+    {
+        errorMessage = "Can't read " + file.getFullPathName();
+        return false;
+    }
+    
+    memcpy(&header, newMap->getData(), sizeof(header));
+    
+    if (memcmp(header.magic, TrafficCapture::magic, sizeof(header.magic)) != 0
+         || header.version != TrafficCapture::version || header.segmentSize < sizeof(TrafficCapture::RecordHeader))
+    {
+        errorMessage = file.getFullPathName() + " is not a bridge capture";
+        return false;
+    }
+    
+    // Unfinished captures: everything after the header, up to the first empty record
+    const juce::int64 available = fileSize - TrafficCapture::dataOffset;
+    dataBytes = header.dataBytes > 0 ? juce::jmin(header.dataBytes, available) : available;
+    
+    if (header.indexOffset < TrafficCapture::dataOffset
+         || header.indexOffset + (juce::int64) header.indexEntries * (juce::int64) sizeof(TrafficCapture::IndexEntry) > fileSize)
+        header.indexEntries = 0;
+    
+    map = std::move(newMap);
+    data = static_cast<const juce::uint8*>(map->getData()) + TrafficCapture::dataOffset;
+    position = 0;
+    return true;
+}
+
+void CaptureReader::close()
+{
+    map.reset();
+    data = nullptr;
+    dataBytes = 0;
+    position = 0;
+}
+
+bool CaptureReader::next(Record& record)
+{
+    constexpr auto headerSize = static_cast<juce::int64>(sizeof(TrafficCapture::RecordHeader));
+    const juce::int64 segmentSize = header.segmentSize;
+    
+    while (data != nullptr && position + headerSize <= dataBytes)
+    {
+        // Less than a header left in the segment: the writer skipped it
+        const juce::int64 segmentEnd = (position / segmentSize + 1) * segmentSize;
+        
+        if (segmentEnd - position < headerSize)
+        {
+            position = segmentEnd;
+            continue;
+        }
+        
+        TrafficCapture::RecordHeader recordHeader;
+        memcpy(&recordHeader, data + position, sizeof(recordHeader));
+        
+        const auto source = static_cast<TrafficCapture::Source>(recordHeader.source);
+        const juce::int64 end = position + headerSize + recordHeader.size;
+        
+        if (source == TrafficCapture::Source::endOfData || end > dataBytes || end > segmentEnd)
+        {
+            position = dataBytes;
+            return false;
+        }
+        
+        const juce::int64 start = position + headerSize;
+        position = end;
+        
+        if (source == TrafficCapture::Source::padding)
+            continue;
+        
+        record.timeUs = recordHeader.timeUs;
+        record.source = source;
+        record.direction = static_cast<TrafficCapture::Direction>(recordHeader.direction);
+        record.flags = recordHeader.flags;
+        record.data = data + start;
+        record.size = static_cast<int>(recordHeader.size);
+        return true;
+    }
+    
+    return false;
+}
+
+void CaptureReader::seek(juce::int64 timeUs)
+{
+    position = 0;
+    
+    if (map == nullptr)
+        return;
+    
+    auto* entries = static_cast<const juce::uint8*>(map->getData()) + header.indexOffset;
+    
+    for (juce::uint32 i = 0; i < header.indexEntries; ++i)
+    {
+        TrafficCapture::IndexEntry entry;
+        memcpy(&entry, entries + i * sizeof(entry), sizeof(entry));
+        
+        if (entry.timeUs > timeUs)
+            break;
+        
+        position = entry.position;
+    }
+}
+
+double CaptureReader::getDurationMs()
+{
+    const auto saved = position;
+    Record record;
+    juce::int64 lastUs = 0;
+    
+    // The index gets us to the last second; scan the rest
+    seek(std::numeric_limits<juce::int64>::max());
+    
+    while (next(record))
+        lastUs = juce::jmax(lastUs, record.timeUs);
+    
+    position = saved;
+    return static_cast<double>(lastUs) * 0.001;
+}
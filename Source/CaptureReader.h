@@ -0,0 +1,56 @@
+#pragma once
+
+#include "TrafficCapture.h"
+
+/**
+ * CaptureReader walks the records of a TrafficCapture file in order. The
+ * file is memory-mapped read-only, so records point straight into it.
+ * Captures that were never stopped (no index, dataBytes 0) are read up to
+ * the first empty record.
+ */
+class CaptureReader
+{
+public:
+    struct Record
+    {
+        juce::int64 timeUs = 0;         // since the capture started
+        TrafficCapture::Source source = TrafficCapture::Source::endOfData;
+        TrafficCapture::Direction direction = TrafficCapture::Direction::in;
+        juce::uint16 flags = 0;
+        const juce::uint8* data = nullptr;
+        int size = 0;
+        
+        double getTimeMs() const { return static_cast<double>(timeUs) * 0.001; }
+        bool is(TrafficCapture::Source s, TrafficCapture::Direction d) const { return source == s && direction == d; }
+    };
+    
+    CaptureReader();
+    
+    bool open(const juce::File& file, juce::String& errorMessage);
+    void close();
+    bool isOpen() const { return map != nullptr; }
+    
+    const TrafficCapture::FileHeader& getHeader() const { return header; }
+    
+    // Next record (padding skipped); false at the end of the data
+    bool next(Record& record);
+    
+    // Back to the first record
+    void rewind() { position = 0; }
+    
+    // Continue from the last indexed record at or before timeUs, so the
+    // next call to next() returns that record or a later one
+    void seek(juce::int64 timeUs);
+    
+    // Time of the last record, found by scanning (ms since the capture started)
+    double getDurationMs();
+    
+private:
+    std::unique_ptr<juce::MemoryMappedFile> map;
+    const juce::uint8* data = nullptr;      // start of the records
+    juce::int64 dataBytes = 0;
+    juce::int64 position = 0;
+    TrafficCapture::FileHeader header {};
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CaptureReader)
+};
@@ -0,0 +1,294 @@
+#include "CaptureReplayer.h"
+
+// Wait for a wall-clock time: sleep while it's far off, yield for the last stretch
+static void waitUntil(double dueMs, const std::atomic<bool>& stopRequested)
+{
+    for (;;)
+    {
+        const double remainingMs = dueMs - juce::Time::getMillisecondCounterHiRes();
+        
+        if (remainingMs <= 0.0 || stopRequested.load())
+            return;
+        
+        if (remainingMs > 2.0)
+            juce::Thread::sleep(static_cast<int>(remainingMs - 1.0));
+        else
+            juce::Thread::yield();
+    }
+}
+
+CaptureReplayer::CaptureReplayer()
+{
+    parser.onMessage = [this](const juce::uint8* data, int size) { handleMessage(data, size); };
+    parser.onRealtimeMessage = [this](juce::uint8 byte) { handleRawOutput(&byte, 1); };
+    parser.onSysExChunk = [this](const juce::uint8* data, int size, bool isLast)
+    {
+        juce::ignoreUnused(isLast);
+        handleRawOutput(data, size);
+    };
+    
+    settings.compile();
+}
+
+void CaptureReplayer::setSettings(const BridgeConfig& newSettings)
+{
+    settings = newSettings;
+    settings.compile();
+}
+
+void CaptureReplayer::setSysExStreaming(bool enabled, int chunkSize)
+{
+    sysExStreaming = enabled;
+    sysExChunkSize = chunkSize;
+}
+
+bool CaptureReplayer::replay(const juce::File& captureFile, Timing timing, juce::String& errorMessage)
+{
+    CaptureReader reader;
+    
+    if (! reader.open(captureFile, errorMessage))
+        return false;
+    
+    results = {};
+    events.clearQuick();
+    eventBytes.clearQuick();
+    noteStates.clear();
+    parser.reset();
+    parser.setSysExStreaming(sysExStreaming, sysExChunkSize);
+    currentTiming = timing;
+    stopRequested = false;
+    
+    CaptureReader::Record record;
+    juce::uint64 streamPosition = 0;
+    const double wallStartMs = juce::Time::getMillisecondCounterHiRes();
+    
+    while (! stopRequested.load() && reader.next(record))
+    {
+        if (! record.is(TrafficCapture::Source::serial, TrafficCapture::Direction::in))
+            continue;
+        
+        if (results.serialRecords == 0)
+        {
+            firstRecordMs = record.getTimeMs();
+            replayStartMs = juce::Time::getMillisecondCounterHiRes();
+        }
+        
+        if (timing == Timing::original)
+        {
+            const double dueMs = replayStartMs + (record.getTimeMs() - firstRecordMs);
+            waitUntil(dueMs, stopRequested);
+            results.maxLatenessMs = juce::jmax(results.maxLatenessMs, juce::Time::getMillisecondCounterHiRes() - dueMs);
+        }
+        
+        // Same calls the bridge's dispatch thread makes for each span of the ring
+        chunkTimeMs = record.getTimeMs();
+        const double parseStartMs = juce::Time::getMillisecondCounterHiRes();
+        
+        parser.setStreamPosition(streamPosition);
+        parser.parse(record.data, record.size);
+        
+        results.processingMs += juce::Time::getMillisecondCounterHiRes() - parseStartMs;
+        
+        streamPosition += static_cast<juce::uint64>(record.size);
+        ++results.serialRecords;
+        results.serialBytes += static_cast<juce::uint64>(record.size);
+        results.captureDurationMs = record.getTimeMs() - firstRecordMs;
+    }
+    
+    results.elapsedMs = juce::Time::getMillisecondCounterHiRes() - wallStartMs;
+    return true;
+}
+
+void CaptureReplayer::handleMessage(const juce::uint8* data, int size)
+{
+    ++results.messagesParsed;
+    
+    juce::MidiMessage message(data, size, chunkTimeMs * 0.001);
+    juce::MidiMessage transformed(message);
+    
+    if (settings.transform(noteStates, message, transformed))
+        addOutput(transformed.getRawData(), transformed.getRawDataSize());
+    else
+        ++results.messagesFiltered;
+}
+
+void CaptureReplayer::handleRawOutput(const juce::uint8* data, int size)
+{
+    // Real-time bytes and SysEx chunks skip the transform, as in the bridge
+    ++results.messagesParsed;
+    addOutput(data, size);
+}
+
+void CaptureReplayer::addOutput(const juce::uint8* data, int size)
+{
+    const double timeMs = getOutputTimeMs();
+    
+    events.add({ static_cast<juce::int64>(timeMs * 1000.0), eventBytes.size(), size });
+    eventBytes.addArray(data, size);
+    ++results.messagesOut;
+    
+    if (onOutput)
+        onOutput(data, size, timeMs);
+}
+
+double CaptureReplayer::getOutputTimeMs() const
+{
+    // As fast as possible there is no real time to speak of: use the
+    // arrival time of the read the message completed in
+    if (currentTiming == Timing::asFastAsPossible)
+        return chunkTimeMs;
+    
+    return firstRecordMs + (juce::Time::getMillisecondCounterHiRes() - replayStartMs);
+}
+
+bool CaptureReplayer::saveOutput(const juce::File& file, juce::String& errorMessage) const
+{
+    TrafficCapture capture;
+    
+    if (! capture.start(file, errorMessage))
+        return false;
+    
+    const double baseMs = capture.getStartTimeMs();
+    
+    for (const auto& event : events)
+    {
+        // Offline, so wait for the flush thread rather than drop anything
+        while (! capture.write(TrafficCapture::Source::midi, TrafficCapture::Direction::out,
+                               baseMs + static_cast<double>(event.timeUs) * 0.001,
+                               eventBytes.getRawDataPointer() + event.offset, event.size))
+            juce::Thread::sleep(1);
+    }
+    
+    capture.stop();
+    return true;
+}
+
+bool CaptureReplayer::compareWith(const juce::File& referenceFile, Diff& diff, juce::String& errorMessage) const
+{
+    CaptureReader reader;
+    
+    if (! reader.open(referenceFile, errorMessage))
+        return false;
+    
+    // The reference's MIDI output, with split records joined up again
+    juce::Array<Event> referenceEvents;
+    juce::Array<juce::uint8> referenceBytes;
+    CaptureReader::Record record;
+    bool joining = false;
+    
+    while (reader.next(record))
+    {
+        if (! record.is(TrafficCapture::Source::midi, TrafficCapture::Direction::out))
+            continue;
+        
+        if (! joining)
+            referenceEvents.add({ record.timeUs, referenceBytes.size(), 0 });
+        
+        referenceBytes.addArray(record.data, record.size);
+        referenceEvents.getReference(referenceEvents.size() - 1).size += record.size;
+        joining = (record.flags & TrafficCapture::continues) != 0;
+    }
+    
+    diff = {};
+    
+    auto isSame = [&](int replayIndex, int referenceIndex)
+    {
+        const auto& a = events.getReference(replayIndex);
+        const auto& b = referenceEvents.getReference(referenceIndex);
+        return a.size == b.size
+                && memcmp(eventBytes.getRawDataPointer() + a.offset, referenceBytes.getRawDataPointer() + b.offset, (size_t) a.size) == 0;
+    };
+    
+    auto describeReplay = [&](int index)
+    {
+        const auto& event = events.getReference(index);
+        return describeEvent(eventBytes.getRawDataPointer() + event.offset, event.size);
+    };
+    
+    auto describeReference = [&](int index)
+    {
+        const auto& event = referenceEvents.getReference(index);
+        return describeEvent(referenceBytes.getRawDataPointer() + event.offset, event.size);
+    };
+    
+    auto report = [&](const juce::String& text)
+    {
+        if (diff.differences.size() < maxReportedDifferences)
+            diff.differences.add(text);
+    };
+    
+    const juce::int64 replayBaseUs = events.isEmpty() ? 0 : events.getReference(0).timeUs;
+    const juce::int64 referenceBaseUs = referenceEvents.isEmpty() ? 0 : referenceEvents.getReference(0).timeUs;
+    
+    // Walk both streams in step; on a difference, look a little way ahead
+    // in each for the nearest point where they line up again
+    constexpr int resyncWindow = 32;
+    int i = 0, j = 0;
+    
+    while (i < events.size() && j < referenceEvents.size())
+    {
+        if (isSame(i, j))
+        {
+            const auto offsetUs = (events.getReference(i).timeUs - replayBaseUs)
+                                    - (referenceEvents.getReference(j).timeUs - referenceBaseUs);
+            diff.maxTimeDifferenceMs = juce::jmax(diff.maxTimeDifferenceMs, std::abs(static_cast<double>(offsetUs)) * 0.001);
+            ++diff.matched;
+            ++i;
+            ++j;
+            continue;
+        }
+        
+        bool resynced = false;
+        
+        for (int k = 1; k <= resyncWindow && ! resynced; ++k)
+        {
+            if (i + k < events.size() && isSame(i + k, j))
+            {
+                for (int n = 0; n < k; ++n)
+                    report("Replay #" + juce::String(i + n) + ": extra " + describeReplay(i + n));
+                
+                diff.extra += k;
+                i += k;
+                resynced = true;
+            }
+            else if (j + k < referenceEvents.size() && isSame(i, j + k))
+            {
+                for (int n = 0; n < k; ++n)
+                    report("Reference #" + juce::String(j + n) + ": missing " + describeReference(j + n));
+                
+                diff.missing += k;
+                j += k;
+                resynced = true;
+            }
+        }
+        
+        if (! resynced)
+        {
+            report("Replay #" + juce::String(i) + ": " + describeReplay(i) + ", reference #" + juce::String(j) + ": " + describeReference(j));
+            ++diff.mismatched;
+            ++i;
+            ++j;
+        }
+    }
+    
+    for (; i < events.size(); ++i, ++diff.extra)
+        report("Replay #" + juce::String(i) + ": extra " + describeReplay(i));
+    
+    for (; j < referenceEvents.size(); ++j, ++diff.missing)
+        report("Reference #" + juce::String(j) + ": missing " + describeReference(j));
+    
+    return true;
+}
+
+juce::String CaptureReplayer::describeEvent(const juce::uint8* data, int size)
+{
+    juce::String text;
+    
+    for (int i = 0; i < juce::jmin(size, 16); ++i)
+        text << juce::String::formatted(i == 0 ? "%02X" : " %02X", data[i]);
+    
+    if (size > 16)
+        text << juce::String::formatted(" ... (%d bytes)", size);
+    
+    return text;
+}
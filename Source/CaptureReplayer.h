@@ -0,0 +1,117 @@
+#pragma once
+
+#include "CaptureReader.h"
+#include "MidiStreamParser.h"
+#include "BridgeConfig.h"
+#include "NoteStateTracker.h"
+
+/**
+ * CaptureReplayer plays the serial input of a TrafficCapture back through
+ * the same MidiStreamParser and BridgeConfig::transform() the bridge uses,
+ * and collects what the bridge would have sent to the MIDI output.
+ *
+ * With Timing::original each read is fed at its recorded time; with
+ * asFastAsPossible everything is fed back to back, which measures the
+ * parser and transform on real traffic. The output can be saved as a
+ * capture of its own and diffed against a reference: either an earlier
+ * replay, or a live capture (whose MIDI output then should come from the
+ * serial port only, not MIDI-in loopback).
+ *
+ * replay() runs on the calling thread; stop() may be called from another.
+ */
+class CaptureReplayer
+{
+public:
+    enum class Timing { original, asFastAsPossible };
+    
+    struct Results
+    {
+        juce::uint64 serialRecords = 0;
+        juce::uint64 serialBytes = 0;
+        juce::uint64 messagesParsed = 0;    // messages, real-time bytes and SysEx chunks
+        juce::uint64 messagesOut = 0;
+        juce::uint64 messagesFiltered = 0;
+        double captureDurationMs = 0.0;     // first to last serial read in the capture
+        double elapsedMs = 0.0;             // wall time of the replay
+        double processingMs = 0.0;          // of which parsing and transforming
+        double maxLatenessMs = 0.0;         // Timing::original: worst late feed
+        
+        double getMessagesPerSecond() const { return processingMs > 0.0 ? static_cast<double>(messagesParsed) * 1000.0 / processingMs : 0.0; }
+        double getBytesPerSecond() const    { return processingMs > 0.0 ? static_cast<double>(serialBytes) * 1000.0 / processingMs : 0.0; }
+    };
+    
+    struct Diff
+    {
+        int matched = 0;
+        int mismatched = 0;     // same place in both streams, different bytes
+        int missing = 0;        // in the reference only
+        int extra = 0;          // in the replay only
+        double maxTimeDifferenceMs = 0.0;   // matched events, each stream timed from its first event
+        juce::StringArray differences;      // the first few, described
+        
+        bool isIdentical() const { return mismatched == 0 && missing == 0 && extra == 0; }
+    };
+    
+    CaptureReplayer();
+    
+    // Transform settings and SysEx mode to replay with (e.g. the bridge's)
+    void setSettings(const BridgeConfig& newSettings);
+    void setSysExStreaming(bool enabled, int chunkSize = 256);
+    
+    // Replay the serial input of a capture. Returns false if it can't be read.
+    bool replay(const juce::File& captureFile, Timing timing, juce::String& errorMessage);
+    
+    // Ask a running replay() to return early
+    void stop() { stopRequested = true; }
+    
+    const Results& getResults() const { return results; }
+    int getNumOutputEvents() const { return events.size(); }
+    
+    // Called on the replay thread for each output message, with its time
+    // on the capture's clock
+    std::function<void(const juce::uint8* data, int size, double timeMs)> onOutput;
+    
+    // Write the output as MIDI-out records of a new capture
+    bool saveOutput(const juce::File& file, juce::String& errorMessage) const;
+    
+    // Compare the output with the MIDI-out records of a capture
+    bool compareWith(const juce::File& referenceFile, Diff& diff, juce::String& errorMessage) const;
+    
+    static constexpr int maxReportedDifferences = 20;
+    
+private:
+    struct Event
+    {
+        juce::int64 timeUs;
+        int offset;     // into eventBytes
+        int size;
+    };
+    
+    // parser callbacks, as in MidiSerialBridge
+    void handleMessage(const juce::uint8* data, int size);
+    void handleRawOutput(const juce::uint8* data, int size);
+    void addOutput(const juce::uint8* data, int size);
+    
+    // Time the current output happens at, on the capture's clock
+    double getOutputTimeMs() const;
+    
+    static juce::String describeEvent(const juce::uint8* data, int size);
+    
+    BridgeConfig settings;
+    NoteStateTracker noteStates;
+    MidiStreamParser parser;
+    bool sysExStreaming = false;
+    int sysExChunkSize = 256;
+    
+    Timing currentTiming = Timing::asFastAsPossible;
+    double chunkTimeMs = 0.0;           // recorded time of the read being parsed
+    double replayStartMs = 0.0;         // wall clock of the first read
+    double firstRecordMs = 0.0;         // capture clock of the first read
+    
+    std::atomic<bool> stopRequested { false };
+    Results results;
+    juce::Array<Event> events;
+    juce::Array<juce::uint8> eventBytes;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CaptureReplayer)
+};
@@ -0,0 +1,692 @@
+// Headless bridge
+//
+// Runs MidiSerialBridge without a window, UI timer or look-and-feel, for
+// Raspberry Pi style boxes and systemd services. Settings come from the
+// command line and/or a config file ("name = value" per line, the same
+// names as the long options, '#' starts a comment); the command line wins.
+//
+//   hairless_bridge --serial /dev/ttyACM0 --midi-out "Synth" --scale-root E --scale minor --diatonic filter
+//   hairless_bridge --config /etc/hairless-bridge.conf
+//
+// SIGINT/SIGTERM stop the bridge cleanly (held notes are released, a
+// running capture is finalised); SIGHUP rereads the config file and applies
+// its ports and transform settings; SIGUSR1 prints the traffic counters.
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+#include <juce_audio_devices/juce_audio_devices.h>
+#include "MidiSerialBridge.h"
+
+#include <atomic>
+#include <cstdio>
+
+#if JUCE_WINDOWS
+    #include <windows.h>
+#else
+    #include <signal.h>
+    #include <pthread.h>
+    #include <thread>
+#endif
+
+//==============================================================================
+struct OptionInfo
+{
+    const char* name;
+    const char* argument;   // nullptr for plain flags
+    const char* help;
+};
+
+static const OptionInfo optionTable[] =
+{
+    { "config",           "<file>",     "read options from a file (name = value per line)" },
+    { "serial",           "<port>",     "serial port name, stable id or \"pty:\" (required)" },
+    { "baud",             "<rate>",     "serial baud rate (default 115200)" },
+    { "midi-in",          "<device>",   "MIDI input to forward to serial (name or index, see --list)" },
+    { "midi-out",         "<device>",   "MIDI output for serial traffic (name or index, see --list)" },
+    { "channel",          "<1-16>",     "output channel for all strings (default 1)" },
+    { "octave",           "<-4..4>",    "global octave shift" },
+    { "string-octaves",   "<6 values>", "per-string octave shifts, comma separated (-4..4)" },
+    { "string-semitones", "<6 values>", "per-string semitone shifts, comma separated (-12..12)" },
+    { "velocity-scales",  "<6 values>", "per-string velocity scales, comma separated (1..10, 10 = unity)" },
+    { "scale-root",       "<note>",     "scale root: C, C#, Db ... B or 0..11 (default C)" },
+    { "scale",            "<name>",     "major, minor, dorian, phrygian, lydian, mixolydian, locrian,\n"
+                                        "                            chromatic, or intervals such as 0,2,4,7,9" },
+    { "diatonic",         "<mode>",     "off, filter (drop notes outside the scale) or replace (move them up)" },
+    { "low-latency",      nullptr,      "request low-latency mode from the serial driver" },
+    { "no-reconnect",     nullptr,      "don't reopen the serial port after I/O errors" },
+    { "sysex-streaming",  nullptr,      MidiSerialBridge::canStreamSysExToMidi
+                                            ? "forward long SysEx in chunks as it arrives"
+                                            : "forward long MIDI -> serial SysEx in chunks as it arrives\n"
+                                              "                            (serial -> MIDI SysEx stays whole on Linux)" },
+    { "output-delay",     "<ms>",       "fixed serial -> MIDI latency (0 sends as soon as parsed)" },
+    { "rt-policy",        "<policy>",   "normal, fifo or rr for the I/O threads" },
+    { "rt-priority",      "<1-99>",     "real-time priority (default 70)" },
+    { "cpus",             "<list>",     "pin the I/O threads, e.g. 2,3 or 0-3" },
+    { "lock-memory",      nullptr,      "lock the process into RAM (mlockall)" },
+    { "capture",          "<file>",     "record all bridged traffic to a capture file" },
+    { "debug",            nullptr,      "print every message passing through the bridge" },
+    { "quiet",            nullptr,      "only print errors" },
+    { "list",             nullptr,      "list serial ports and MIDI devices, then exit" },
+    { "help",             nullptr,      "show this help" }
+};
+
+static const OptionInfo* findOption(const juce::String& name)
+{
+    for (auto& option : optionTable)
+        if (name == option.name)
+            return &option;
+
+    return nullptr;
+}
+
+static void printUsage(const char* argv0)
+{
+    std::fprintf(stderr, "Usage: %s --serial <port> [--midi-in <device>] [--midi-out <device>] [options]\n\n", argv0);
+
+    for (auto& option : optionTable)
+    {
+        const juce::String flag = juce::String("--") + option.name + " " + (option.argument != nullptr ? option.argument : "");
+        std::fprintf(stderr, "  %-26s%s\n", flag.toRawUTF8(), option.help);
+    }
+}
+
+//==============================================================================
+// Output goes to stdout (journald picks it up under systemd); callbacks come
+// from the bridge's threads, so lines are written whole
+static juce::CriticalSection outputLock;
+
+static void printLine(const juce::String& text, FILE* stream = stdout)
+{
+    const juce::ScopedLock sl(outputLock);
+    std::fprintf(stream, "%s\n", text.toRawUTF8());
+    std::fflush(stream);
+}
+
+//==============================================================================
+// Command line: "--name value", "--name=value" or "--flag"
+static bool parseCommandLine(int argc, char* argv[], juce::StringPairArray& options, juce::String& error)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg(juce::CharPointer_UTF8(argv[i]));
+
+        if (! arg.startsWith("--"))
+        {
+            error = "Unexpected argument: " + arg;
+            return false;
+        }
+
+        const juce::String name = arg.substring(2).upToFirstOccurrenceOf("=", false, false);
+        const OptionInfo* option = findOption(name);
+
+        if (option == nullptr)
+        {
+            error = "Unknown option: --" + name;
+            return false;
+        }
+
+        if (arg.contains("="))
+            options.set(name, arg.fromFirstOccurrenceOf("=", false, false));
+        else if (option->argument == nullptr)
+            options.set(name, "yes");
+        else if (i + 1 < argc)
+            options.set(name, juce::String(juce::CharPointer_UTF8(argv[++i])));
+        else
+        {
+            error = "--" + name + " needs a value";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool loadConfigFile(const juce::File& file, juce::StringPairArray& options, juce::String& error)
+{
+    if (! file.existsAsFile())
+    {
+        error = "Config file not found: " + file.getFullPathName();
+        return false;
+    }
+
+    juce::StringArray lines;
+    lines.addLines(file.loadFileAsString());
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        const juce::String line = lines[i].upToFirstOccurrenceOf("#", false, false).trim();
+
+        if (line.isEmpty())
+            continue;
+
+        const juce::String name = line.upToFirstOccurrenceOf("=", false, false).trim();
+        const OptionInfo* option = findOption(name);
+
+        if (option == nullptr || name == "config")
+        {
+            error = file.getFileName() + ":" + juce::String(i + 1) + ": unknown option '" + name + "'";
+            return false;
+        }
+
+        if (line.contains("="))
+            options.set(name, line.fromFirstOccurrenceOf("=", false, false).trim().unquoted());
+        else if (option->argument == nullptr)
+            options.set(name, "yes");
+        else
+        {
+            error = file.getFileName() + ":" + juce::String(i + 1) + ": '" + name + "' needs a value";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Config file first, then the command line on top
+static bool gatherOptions(const juce::StringPairArray& commandLine, juce::StringPairArray& options, juce::String& error)
+{
+    options.clear();
+
+    if (commandLine.containsKey("config")
+         && ! loadConfigFile(juce::File::getCurrentWorkingDirectory().getChildFile(commandLine["config"]), options, error))
+        return false;
+
+    for (int i = 0; i < commandLine.size(); ++i)
+        options.set(commandLine.getAllKeys()[i], commandLine.getAllValues()[i]);
+
+    return true;
+}
+
+//==============================================================================
+static bool getFlag(const juce::StringPairArray& options, const char* name)
+{
+    const juce::String value = options[name].trim().toLowerCase();
+    return value == "yes" || value == "true" || value == "on" || value == "1";
+}
+
+static bool parseInt(const juce::String& text, int minValue, int maxValue, int& value)
+{
+    const juce::String trimmed = text.trim();
+    const juce::String digits = trimmed.startsWithChar('-') || trimmed.startsWithChar('+') ? trimmed.substring(1) : trimmed;
+
+    if (digits.isEmpty() || ! digits.containsOnly("0123456789"))
+        return false;
+
+    value = trimmed.getIntValue();
+    return value >= minValue && value <= maxValue;
+}
+
+static bool parseIntList(const juce::String& text, int minValue, int maxValue, int (&values)[6])
+{
+    const auto items = juce::StringArray::fromTokens(text, ",", "");
+
+    if (items.size() != 6)
+        return false;
+
+    for (int i = 0; i < 6; ++i)
+        if (! parseInt(items[i], minValue, maxValue, values[i]))
+            return false;
+
+    return true;
+}
+
+static bool parseRootNote(const juce::String& text, int& rootNotePc)
+{
+    static const char* sharps[] = { "C","C#","D","D#","E","F","F#","G","G#","A","A#","B" };
+    static const char* flats[]  = { "C","Db","D","Eb","E","Fb","Gb","G","Ab","A","Bb","Cb" };
+
+    for (int pc = 0; pc < 12; ++pc)
+    {
+        if (text.equalsIgnoreCase(sharps[pc]) || text.equalsIgnoreCase(flats[pc]))
+        {
+            rootNotePc = pc;
+            return true;
+        }
+    }
+
+    return parseInt(text, 0, 11, rootNotePc);
+}
+
+// Same interval sets as the scale menu in the GUI
+static bool parseScale(const juce::String& text, juce::Array<int>& intervals)
+{
+    const juce::String name = text.trim().toLowerCase();
+
+    if (name == "major" || name == "ionian")        intervals = { 0,2,4,5,7,9,11 };
+    else if (name == "minor" || name == "aeolian")  intervals = { 0,2,3,5,7,8,10 };
+    else if (name == "dorian")                      intervals = { 0,2,3,5,7,9,10 };
+    else if (name == "phrygian")                    intervals = { 0,1,3,5,7,8,10 };
+    else if (name == "lydian")                      intervals = { 0,2,4,6,7,9,11 };
+    else if (name == "mixolydian")                  intervals = { 0,2,4,5,7,9,10 };
+    else if (name == "locrian")                     intervals = { 0,1,3,5,6,8,10 };
+    else if (name == "chromatic")                   intervals = { 0,1,2,3,4,5,6,7,8,9,10,11 };
+    else
+    {
+        intervals.clear();
+
+        for (auto item : juce::StringArray::fromTokens(name, ",", ""))
+        {
+            int interval = 0;
+            if (! parseInt(item, 0, 11, interval))
+                return false;
+
+            intervals.addIfNotAlreadyThere(interval);
+        }
+
+        return ! intervals.isEmpty();
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Transform settings, validated as a whole before any is applied so a bad
+// config reload leaves the running bridge as it was
+struct TransformSettings
+{
+    int channel = 1;
+    int octave = 0;
+    int stringOctaves[6] = { 0, 0, 0, 0, 0, 0 };
+    int stringSemitones[6] = { 0, 0, 0, 0, 0, 0 };
+    int velocityScales[6] = { 10, 10, 10, 10, 10, 10 };
+    int rootNotePc = 0;
+    juce::Array<int> intervals { 0,2,4,5,7,9,11 };
+    MidiSerialBridge::DiatonicMode diatonicMode = MidiSerialBridge::DiatonicMode::Off;
+};
+
+static bool parseTransformSettings(const juce::StringPairArray& options, TransformSettings& settings, juce::String& error)
+{
+    if (options.containsKey("channel") && ! parseInt(options["channel"], 1, 16, settings.channel))
+        error = "--channel must be 1..16";
+    else if (options.containsKey("octave") && ! parseInt(options["octave"], -4, 4, settings.octave))
+        error = "--octave must be -4..4";
+    else if (options.containsKey("string-octaves") && ! parseIntList(options["string-octaves"], -4, 4, settings.stringOctaves))
+        error = "--string-octaves needs 6 values in -4..4";
+    else if (options.containsKey("string-semitones") && ! parseIntList(options["string-semitones"], -12, 12, settings.stringSemitones))
+        error = "--string-semitones needs 6 values in -12..12";
+    else if (options.containsKey("velocity-scales") && ! parseIntList(options["velocity-scales"], 1, 10, settings.velocityScales))
+        error = "--velocity-scales needs 6 values in 1..10";
+    else if (options.containsKey("scale-root") && ! parseRootNote(options["scale-root"], settings.rootNotePc))
+        error = "--scale-root must be a note name (C, F#, Bb...) or 0..11";
+    else if (options.containsKey("scale") && ! parseScale(options["scale"], settings.intervals))
+        error = "--scale must be a scale name or a list of intervals 0..11";
+    else if (options.containsKey("diatonic"))
+    {
+        const juce::String mode = options["diatonic"].trim().toLowerCase();
+
+        if (mode == "off")              settings.diatonicMode = MidiSerialBridge::DiatonicMode::Off;
+        else if (mode == "filter")      settings.diatonicMode = MidiSerialBridge::DiatonicMode::Filter;
+        else if (mode == "replace")     settings.diatonicMode = MidiSerialBridge::DiatonicMode::ReplaceUp;
+        else error = "--diatonic must be off, filter or replace";
+    }
+
+    return error.isEmpty();
+}
+
+static void applyTransformSettings(MidiSerialBridge& bridge, const TransformSettings& settings)
+{
+    bridge.setUnifiedChannel(settings.channel);
+    bridge.setGlobalOctaveShift(settings.octave);
+
+    for (int i = 0; i < 6; ++i)
+    {
+        bridge.setStringOctaveShift(i, settings.stringOctaves[i]);
+        bridge.setStringSemitoneShift(i, settings.stringSemitones[i]);
+        bridge.setStringVelocityScale(i, settings.velocityScales[i]);
+    }
+
+    // Same pairing of mode and filter switch as the GUI's diatonic menu
+    bridge.setScale(settings.rootNotePc, settings.intervals);
+    bridge.setDiatonicMode(settings.diatonicMode);
+    bridge.setFilterEnabled(settings.diatonicMode != MidiSerialBridge::DiatonicMode::Off);
+}
+
+// Settings that only take effect when the serial session opens
+struct SessionSettings
+{
+    int baudRate = 115200;
+    int outputDelayMs = 0;
+    RealtimeOptions realtime;
+};
+
+static bool parseSessionSettings(const juce::StringPairArray& options, SessionSettings& session, juce::String& error)
+{
+    RealtimeOptions& realtime = session.realtime;
+
+    if (options.containsKey("baud") && ! parseInt(options["baud"], 1, 4000000, session.baudRate))
+        error = "--baud must be a positive rate";
+
+    if (options.containsKey("output-delay") && ! parseInt(options["output-delay"], 0, 1000, session.outputDelayMs))
+        error = "--output-delay must be 0..1000 ms";
+
+    const juce::String policy = options["rt-policy"].trim().toLowerCase();
+
+    if (policy == "fifo")                           realtime.policy = RealtimeOptions::Policy::fifo;
+    else if (policy == "rr")                        realtime.policy = RealtimeOptions::Policy::roundRobin;
+    else if (policy.isNotEmpty() && policy != "normal")
+        error = "--rt-policy must be normal, fifo or rr";
+
+    if (options.containsKey("rt-priority") && ! parseInt(options["rt-priority"], 1, 99, realtime.priority))
+        error = "--rt-priority must be 1..99";
+
+    if (options.containsKey("cpus") && ! RealtimeThreading::parseCpuList(options["cpus"], realtime.cpuMask))
+        error = "--cpus must be a CPU list such as 2,3 or 0-3";
+
+    realtime.lockMemory = getFlag(options, "lock-memory");
+    return error.isEmpty();
+}
+
+//==============================================================================
+// The bridge opens ports by exact name; accept an index or a unique
+// case-insensitive substring too. Empty stays empty (endpoint unused).
+static bool resolveMidiDevice(const juce::String& text, const juce::Array<juce::MidiDeviceInfo>& devices,
+                              const char* what, juce::String& name, juce::String& error)
+{
+    name = {};
+
+    if (text.isEmpty())
+        return true;
+
+    int index = 0;
+    if (parseInt(text, 0, devices.size() - 1, index))
+    {
+        name = devices[index].name;
+        return true;
+    }
+
+    juce::StringArray matches;
+
+    for (auto& device : devices)
+    {
+        if (device.name == text)
+        {
+            name = device.name;
+            return true;
+        }
+
+        if (device.name.containsIgnoreCase(text))
+            matches.add(device.name);
+    }
+
+    if (matches.size() == 1)
+    {
+        name = matches[0];
+        return true;
+    }
+
+    error = juce::String(what) + (matches.isEmpty() ? " not found: " : " is ambiguous: ") + text
+            + (matches.isEmpty() ? juce::String(" (see --list)") : " (" + matches.joinIntoString(", ") + ")");
+    return false;
+}
+
+// Display names and stable ids map to the port name; anything else
+// (a device path, "pty:") is passed through for the port to open
+static juce::String resolveSerialPort(const juce::String& text)
+{
+    for (auto& port : SerialPortManager::scanPorts())
+        if (text == port.portName || text == port.stableId || text == port.getDisplayName())
+            return port.portName;
+
+    return text;
+}
+
+static bool resolvePorts(const juce::StringPairArray& options, juce::String& serialPort,
+                         juce::String& midiIn, juce::String& midiOut, juce::String& error)
+{
+    if (options["serial"].trim().isEmpty())
+    {
+        error = "--serial is required";
+        return false;
+    }
+
+    serialPort = resolveSerialPort(options["serial"].trim());
+
+    return resolveMidiDevice(options["midi-in"].trim(), juce::MidiInput::getAvailableDevices(), "MIDI input", midiIn, error)
+        && resolveMidiDevice(options["midi-out"].trim(), juce::MidiOutput::getAvailableDevices(), "MIDI output", midiOut, error);
+}
+
+static void listDevices()
+{
+    printLine("Serial ports:");
+    for (auto& port : SerialPortManager::scanPorts())
+        printLine("  " + port.portName
+                  + (port.getDisplayName() != port.portName ? "  (" + port.getDisplayName() + ")" : juce::String())
+                  + (port.stableId.isNotEmpty() ? "  " + port.stableId : juce::String()));
+
+    printLine("MIDI inputs:");
+    auto inputs = juce::MidiInput::getAvailableDevices();
+    for (int i = 0; i < inputs.size(); ++i)
+        printLine("  " + juce::String(i) + ": " + inputs[i].name);
+
+    printLine("MIDI outputs:");
+    auto outputs = juce::MidiOutput::getAvailableDevices();
+    for (int i = 0; i < outputs.size(); ++i)
+        printLine("  " + juce::String(i) + ": " + outputs[i].name);
+}
+
+static void printStats(MidiSerialBridge& bridge)
+{
+    const auto rx = bridge.getSerialRxStats();
+    const auto tx = bridge.getSerialTxStats();
+    const auto parser = bridge.getSerialParserStats();
+    const auto latency = bridge.getSerialLatencyStats();
+
+    printLine("Serial in: " + juce::String(rx.bytesReceived) + " bytes, " + juce::String(parser.messages)
+              + " messages; serial out: " + juce::String(tx.bytesWritten) + " bytes, "
+              + juce::String(tx.bytesDropped) + " dropped; latency avg "
+              + juce::String(latency.averageMs, 2) + " ms, max " + juce::String(latency.maxMs, 2) + " ms");
+}
+
+//==============================================================================
+// Signals are turned into bits for the main thread to act on
+enum SignalBits
+{
+    quitRequested = 1,
+    reloadRequested = 2,
+    statsRequested = 4
+};
+
+static std::atomic<int> pendingSignals { 0 };
+static juce::WaitableEvent signalEvent;
+
+static void raiseSignal(int bits)
+{
+    pendingSignals.fetch_or(bits);
+    signalEvent.signal();
+}
+
+#if JUCE_WINDOWS
+static BOOL WINAPI consoleControlHandler(DWORD)
+{
+    raiseSignal(quitRequested);
+    return TRUE;
+}
+
+static void startSignalHandling()
+{
+    SetConsoleCtrlHandler(consoleControlHandler, TRUE);
+}
+#else
+static sigset_t handledSignals()
+{
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    sigaddset(&set, SIGHUP);
+    sigaddset(&set, SIGUSR1);
+    return set;
+}
+
+// Must run before any other thread exists, so that all of them inherit
+// the mask and the signals reach only the sigwait() thread
+static void blockSignals()
+{
+    const sigset_t set = handledSignals();
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+}
+
+static void startSignalHandling()
+{
+    std::thread([]
+    {
+        const sigset_t set = handledSignals();
+
+        for (;;)
+        {
+            int signal = 0;
+            if (sigwait(&set, &signal) != 0)
+                continue;
+
+            raiseSignal(signal == SIGHUP ? reloadRequested : signal == SIGUSR1 ? statsRequested : quitRequested);
+        }
+    }).detach();
+}
+#endif
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+   #if ! JUCE_WINDOWS
+    blockSignals();
+   #endif
+
+    juce::StringPairArray commandLine, options;
+    juce::String error;
+
+    if (! parseCommandLine(argc, argv, commandLine, error))
+    {
+        std::fprintf(stderr, "%s\n\n", error.toRawUTF8());
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    if (commandLine.containsKey("help"))
+    {
+        printUsage(argv[0]);
+        return 0;
+    }
+
+    // The message manager without a window: MIDI device handling expects
+    // one to exist, but nothing in the bridge needs its loop to run
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    if (commandLine.containsKey("list"))
+    {
+        listDevices();
+        return 0;
+    }
+
+    TransformSettings transform;
+    SessionSettings session;
+    juce::String serialPort, midiIn, midiOut;
+
+    const bool valid = gatherOptions(commandLine, options, error)
+                        && parseTransformSettings(options, transform, error)
+                        && parseSessionSettings(options, session, error)
+                        && resolvePorts(options, serialPort, midiIn, midiOut, error);
+
+    if (! valid)
+    {
+        printLine(error, stderr);
+        return 2;
+    }
+
+    const bool quiet = getFlag(options, "quiet");
+    const bool debug = getFlag(options, "debug");
+
+    MidiSerialBridge bridge;
+
+    if (! quiet)
+        bridge.onDisplayMessage = [](const juce::String& message) { printLine(message); };
+
+    if (debug)
+    {
+        bridge.onDebugMessage = [](const juce::String& message) { printLine(message); };
+        bridge.setDebugLogging(true);
+    }
+
+    bridge.setSerialBaudRate(session.baudRate);
+    bridge.setSerialLowLatency(getFlag(options, "low-latency"));
+    bridge.setAutoReconnect(! getFlag(options, "no-reconnect"));
+    bridge.setSysExStreaming(getFlag(options, "sysex-streaming"));
+    bridge.setOutputDelay(session.outputDelayMs);
+    bridge.setRealtimeOptions(session.realtime);
+    applyTransformSettings(bridge, transform);
+
+    if (options.containsKey("capture")
+         && ! bridge.startCapture(juce::File::getCurrentWorkingDirectory().getChildFile(options["capture"]), error))
+    {
+        printLine("Can't capture: " + error, stderr);
+        return 1;
+    }
+
+    startSignalHandling();
+    bridge.attach(serialPort, midiIn, midiOut);
+
+    // Without the serial side there is nothing to bridge; exit non-zero so
+    // a service manager can retry (once open, the bridge reconnects itself)
+    if (! bridge.isSerialOpen())
+    {
+        printLine("Can't open serial port " + serialPort, stderr);
+        bridge.detach();
+        bridge.stopCapture();
+        return 1;
+    }
+
+    if (! quiet)
+        printLine(bridge.getScaleDescription());
+
+    for (;;)
+    {
+        // The debug log is drained here, as the GUI's timer does
+        signalEvent.wait(debug ? 50 : -1);
+
+        if (debug)
+            bridge.drainDebugLog();
+
+        const int signals = pendingSignals.exchange(0);
+
+        if ((signals & quitRequested) != 0)
+            break;
+
+        if ((signals & statsRequested) != 0)
+            printStats(bridge);
+
+        if ((signals & reloadRequested) != 0)
+        {
+            // Session settings (baud rate, threads) need a restart; ports
+            // and transform settings are swapped in place
+            TransformSettings reloaded;
+
+            if (gatherOptions(commandLine, options, error)
+                 && parseTransformSettings(options, reloaded, error)
+                 && resolvePorts(options, serialPort, midiIn, midiOut, error))
+            {
+                applyTransformSettings(bridge, reloaded);
+                bridge.setSerialPort(serialPort);
+                bridge.setMidiInput(midiIn);
+                bridge.setMidiOutput(midiOut);
+                printLine("Configuration reloaded: " + bridge.getScaleDescription());
+            }
+            else
+            {
+                printLine("Configuration not reloaded: " + error, stderr);
+                error = {};
+            }
+        }
+    }
+
+    // Detach first: the note-offs it sends for held notes belong in the
+    // capture too
+    bridge.detach();
+    bridge.stopCapture();
+
+    if (debug)
+        bridge.drainDebugLog();
+
+    if (! quiet)
+        printStats(bridge);
+
+    return 0;
+}
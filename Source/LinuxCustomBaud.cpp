@@ -0,0 +1,33 @@
+#include "LinuxCustomBaud.h"
+
+// Nothing here may include <termios.h> (or JUCE, which might): see the header
+#if defined(__linux__)
+    #include <asm/termbits.h>
+    #include <sys/ioctl.h>
+#endif
+
+bool setLinuxCustomBaudRate(int fd, int baudRate, int& effectiveBaud)
+{
+   #if defined(__linux__) && defined(TCGETS2) && defined(BOTHER)
+    struct termios2 tio;
+    
+    if (ioctl(fd, TCGETS2, &tio) != 0)
+        return false;
+    
+    tio.c_cflag &= ~CBAUD;
+    tio.c_cflag |= BOTHER;
+    tio.c_ispeed = static_cast<speed_t>(baudRate);
+    tio.c_ospeed = static_cast<speed_t>(baudRate);
+    
+    if (ioctl(fd, TCSETS2, &tio) != 0 || ioctl(fd, TCGETS2, &tio) != 0)
+        return false;
+    
+    effectiveBaud = static_cast<int>(tio.c_ospeed);
+    return true;
+   #else
+    (void) fd;
+    (void) baudRate;
+    (void) effectiveBaud;
+    return false;
+   #endif
+}
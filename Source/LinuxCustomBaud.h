@@ -0,0 +1,14 @@
+#pragma once
+
+/**
+ * Line rates with no Bxxx constant (31250 for DIN MIDI, say) on Linux,
+ * through the kernel's termios2 and the TCGETS2/TCSETS2 ioctls.
+ *
+ * This lives in a translation unit of its own: the real struct termios2
+ * only comes from <asm/termbits.h>, whose layout (NCCS) differs between
+ * architectures and which clashes with glibc's <termios.h>.
+ */
+
+// Set fd's rate to baudRate. On success effectiveBaud holds the rate the
+// driver actually accepted. False if the ioctls fail or aren't available.
+bool setLinuxCustomBaudRate(int fd, int baudRate, int& effectiveBaud);
@@ -32,15 +32,45 @@ MainComponent::MainComponent()
     addAndMakeVisible(midiInCombo);
     addAndMakeVisible(midiOutCombo);
     
-    serialCombo.onChange = [this] { onConnectionChanged(); };
-    midiInCombo.onChange = [this] { onConnectionChanged(); };
-    midiOutCombo.onChange = [this] { onConnectionChanged(); };
+    serialCombo.onChange = [this] { onSerialPortChanged(); };
+    
+    // Editable so network/replay transports can be typed in
+    serialCombo.setEditableText(true);
+    serialCombo.setTooltip("Serial port, or tcp://host:port, file:/path/capture.bin");
+    midiInCombo.onChange = [this] { onMidiInputChanged(); };
+    midiOutCombo.onChange = [this] { onMidiOutputChanged(); };
+    
+    // Baud rate: common Arduino rates, DIN MIDI (31250) and native-USB rates
+    static const int baudRates[] = { 9600, 19200, 31250, 38400, 57600, 115200, 230400,
+                                     250000, 460800, 500000, 921600, 1000000, 2000000 };
+    for (int rate : baudRates)
+        baudCombo.addItem(juce::String(rate), rate);
+    baudCombo.setEditableText(true);
+    baudCombo.setTooltip("Baud rate (select or type any value)");
+    baudCombo.setSelectedId(bridge.getSerialBaudRate(), juce::dontSendNotification);
+    baudCombo.onChange = [this] { onBaudRateChanged(); };
+    addAndMakeVisible(baudCombo);
     
     // Setup toggle buttons
     bridgeToggle.setButtonText("Bridge Active");
     bridgeToggle.onClick = [this] { onBridgeToggled(); };
     addAndMakeVisible(bridgeToggle);
     
+    lowLatencyToggle.setButtonText("Low Latency");
+    lowLatencyToggle.setTooltip("Low-latency serial mode (USB-serial latency timer 1 ms)");
+    lowLatencyToggle.setToggleState(bridge.getSerialLowLatency(), juce::dontSendNotification);
+    lowLatencyToggle.onClick = [this] { onLowLatencyToggled(); };
+    addAndMakeVisible(lowLatencyToggle);
+    
+    sysExStreamingToggle.setButtonText("Stream SysEx");
+    sysExStreamingToggle.setTooltip(MidiSerialBridge::canStreamSysExToMidi
+                                        ? "Forward SysEx in 256-byte chunks as it arrives (no size limit)"
+                                        : "Forward MIDI -> serial SysEx in 256-byte chunks as it arrives (no size limit). "
+                                          "Serial -> MIDI SysEx stays whole: ALSA can't send it in pieces");
+    sysExStreamingToggle.setToggleState(bridge.getSysExStreaming(), juce::dontSendNotification);
+    sysExStreamingToggle.onClick = [this] { onSysExStreamingToggled(); };
+    addAndMakeVisible(sysExStreamingToggle);
+    
     // Toggle debug rimosso
     
     // Setup text editors (read-only)
@@ -69,7 +99,8 @@ MainComponent::MainComponent()
     serialLEDLabel.setVisible(false);
     
     // Setup bridge callbacks
-    // Nessun collegamento a messaggi di log
+    // Nessun collegamento a messaggi di log, tranne il debug log (svuotato da timerCallback)
+    bridge.onDebugMessage = [this](const juce::String& message) { addDebugMessage(message); };
     bridge.onMidiReceived = [this]() { midiInBlinkCounter = LED_BLINK_DURATION; };
     bridge.onMidiSent = [this]() { midiOutBlinkCounter = LED_BLINK_DURATION; };
     bridge.onSerialTraffic = [this]() { serialBlinkCounter = LED_BLINK_DURATION; };
@@ -175,7 +206,9 @@ MainComponent::MainComponent()
     diatonicModeCombo.onChange = [this]() { onDiatonicModeChanged(); };
     addAndMakeVisible(diatonicModeCombo);
 
-    // Initial refresh
+    // Initial refresh, then follow serial hotplug events
+    SerialPortRegistry::getInstance()->addChangeListener(this);
+    SerialPortRegistry::getInstance()->startMonitoring();
     refreshSerialPorts();
     refreshMidiInputs();
     refreshMidiOutputs();
@@ -195,6 +228,8 @@ MainComponent::MainComponent()
 
 MainComponent::~MainComponent()
 {
+    SerialPortRegistry::getInstance()->removeChangeListener(this);
+    SerialPortRegistry::getInstance()->stopMonitoring();
     bridge.detach();
 }
 
@@ -245,7 +280,7 @@ void MainComponent::resized()
     grid.items.add(juce::GridItem(serialLabel).withArea(1, 1));
     grid.items.add(juce::GridItem(serialCombo).withArea(1, 2));
     grid.items.add(juce::GridItem(serialLED).withArea(1, 3).withAlignSelf(juce::GridItem::AlignSelf::center));
-    grid.items.add(juce::GridItem().withArea(1, 4)); // filler
+    grid.items.add(juce::GridItem(baudCombo).withArea(1, 4).withWidth(120));
 
         // Row 2: MIDI In
     grid.items.add(juce::GridItem(midiInLabel).withArea(2, 1));
@@ -261,9 +296,9 @@ void MainComponent::resized()
 
     // Row 4: Solo toggle Bridge
     grid.items.add(juce::GridItem(bridgeToggle).withArea(4, 1));
-    grid.items.add(juce::GridItem().withArea(4, 2));
+    grid.items.add(juce::GridItem(lowLatencyToggle).withArea(4, 2));
     grid.items.add(juce::GridItem().withArea(4, 3));
-    grid.items.add(juce::GridItem().withArea(4, 4));
+    grid.items.add(juce::GridItem(sysExStreamingToggle).withArea(4, 4));
 
         grid.performLayout(connInner);
         // Size LEDs to 24x24 and center vertically within their grid cell
@@ -359,6 +394,9 @@ void MainComponent::resized()
 
 void MainComponent::timerCallback()
 {
+    // Debug records are formatted here, off the MIDI and serial threads
+    bridge.drainDebugLog();
+    
     // Update LED blink counters
     if (midiInBlinkCounter > 0)
     {
@@ -394,11 +432,11 @@ void MainComponent::timerCallback()
 void MainComponent::refreshSerialPorts()
 {
     auto currentSelection = serialCombo.getText();
-    serialCombo.clear();
+    serialCombo.clear(juce::dontSendNotification); // hotplug refreshes must not reattach
     
     serialCombo.addItem("(Not Connected)", 1);
     
-    auto ports = SerialPortManager::getAvailablePorts();
+    auto ports = SerialPortRegistry::getInstance()->getPorts();
     int id = 2;
     
     for (auto& port : ports)
@@ -409,6 +447,20 @@ void MainComponent::refreshSerialPorts()
             serialCombo.setSelectedId(id - 1, juce::dontSendNotification);
     }
     
+   #if ! JUCE_WINDOWS
+    // Built-in pty loopback, for driving the bridge without hardware
+    serialCombo.addItem(loopbackItemName, id);
+    if (currentSelection == loopbackItemName)
+        serialCombo.setSelectedId(id, juce::dontSendNotification);
+   #endif
+    
+    // Keep a typed-in transport URL across refreshes
+    if (serialCombo.getSelectedId() == 0 && ! SerialTransport::isDevicePortName(currentSelection))
+    {
+        serialCombo.setText(currentSelection, juce::dontSendNotification);
+        return;
+    }
+    
     // Default to COM1 if available
     if (serialCombo.getSelectedId() == 0)
     {
@@ -427,6 +479,35 @@ void MainComponent::refreshSerialPorts()
     }
 }
 
+void MainComponent::changeListenerCallback(juce::ChangeBroadcaster* source)
+{
+    if (source == SerialPortRegistry::getInstance())
+        refreshSerialPorts();
+}
+
+juce::String MainComponent::getSelectedSerialPortPath()
+{
+    // Typed-in tcp:// or file: transport
+    if (serialCombo.getSelectedId() == 0)
+    {
+        auto typed = serialCombo.getText().trim();
+        return SerialTransport::isDevicePortName(typed) ? juce::String() : typed;
+    }
+    
+    if (serialCombo.getSelectedId() == 1)
+        return {};
+    
+    if (serialCombo.getText() == loopbackItemName)
+        return SerialPortManager::pseudoTerminalPortName;
+    
+    // Cached lookup: no rescan of the system
+    SerialPortRegistry::PortInfo port;
+    if (SerialPortRegistry::getInstance()->findByDisplayName(serialCombo.getText(), port))
+        return port.portName;
+    
+    return serialCombo.getText();
+}
+
 void MainComponent::refreshMidiInputs()
 {
     auto currentSelection = midiInCombo.getText();
@@ -502,24 +583,10 @@ void MainComponent::onBridgeToggled()
     if (bridgeToggle.getToggleState())
     {
         // Start bridging
-        juce::String serialPort = serialCombo.getSelectedId() > 1 ? serialCombo.getText() : juce::String();
+        juce::String serialPort = getSelectedSerialPortPath();
         juce::String midiIn = midiInCombo.getSelectedId() > 1 ? midiInCombo.getText() : juce::String();
         juce::String midiOut = midiOutCombo.getSelectedId() > 1 ? midiOutCombo.getText() : juce::String();
         
-        // Get actual port names for serial
-        if (serialPort.isNotEmpty())
-        {
-            auto ports = SerialPortManager::getAvailablePorts();
-            for (auto& port : ports)
-            {
-                if (port.getDisplayName() == serialPort)
-                {
-                    serialPort = port.portName;
-                    break;
-                }
-            }
-        }
-        
         bridge.attach(serialPort, midiIn, midiOut);
     }
     else
@@ -531,38 +598,65 @@ void MainComponent::onBridgeToggled()
 
 void MainComponent::onDebugToggled()
 {
+    bridge.setDebugLogging(debugToggle.getToggleState());
     debugList.setVisible(debugToggle.getToggleState());
     debugLabel.setVisible(debugToggle.getToggleState());
     resized();
 }
 
-void MainComponent::onConnectionChanged()
+// Endpoint changes only swap the endpoint that changed, so e.g. picking a
+// new MIDI output doesn't reopen (and reset) the Arduino
+void MainComponent::onSerialPortChanged(bool forceReopen)
 {
-    // If bridge is active, restart it with new settings
     if (bridgeToggle.getToggleState())
+        bridge.setSerialPort(getSelectedSerialPortPath(), forceReopen);
+}
+
+void MainComponent::onMidiInputChanged()
+{
+    if (bridgeToggle.getToggleState())
+        bridge.setMidiInput(midiInCombo.getSelectedId() > 1 ? midiInCombo.getText() : juce::String());
+}
+
+void MainComponent::onMidiOutputChanged()
+{
+    if (bridgeToggle.getToggleState())
+        bridge.setMidiOutput(midiOutCombo.getSelectedId() > 1 ? midiOutCombo.getText() : juce::String());
+}
+
+void MainComponent::onBaudRateChanged()
+{
+    int rate = baudCombo.getText().trim().getIntValue();
+    
+    if (rate <= 0)
     {
-        bridge.detach();
-        
-        juce::String serialPort = serialCombo.getSelectedId() > 1 ? serialCombo.getText() : juce::String();
-        juce::String midiIn = midiInCombo.getSelectedId() > 1 ? midiInCombo.getText() : juce::String();
-        juce::String midiOut = midiOutCombo.getSelectedId() > 1 ? midiOutCombo.getText() : juce::String();
-        
-        // Get actual port names for serial
-        if (serialPort.isNotEmpty())
-        {
-            auto ports = SerialPortManager::getAvailablePorts();
-            for (auto& port : ports)
-            {
-                if (port.getDisplayName() == serialPort)
-                {
-                    serialPort = port.portName;
-                    break;
-                }
-            }
-        }
-        
-        bridge.attach(serialPort, midiIn, midiOut);
+        // Not a number: restore the current rate
+        baudCombo.setText(juce::String(bridge.getSerialBaudRate()), juce::dontSendNotification);
+        return;
     }
+    
+    if (rate == bridge.getSerialBaudRate())
+        return;
+    
+    bridge.setSerialBaudRate(rate);
+    onSerialPortChanged(true);
+}
+
+void MainComponent::onLowLatencyToggled()
+{
+    bridge.setSerialLowLatency(lowLatencyToggle.getToggleState());
+    onSerialPortChanged(true);
+}
+
+void MainComponent::onSysExStreamingToggled()
+{
+    bridge.setSysExStreaming(sysExStreamingToggle.getToggleState());
+    
+    // MIDI -> serial picks the setting up straight away; only the serial
+    // parser needs a new session, and it never streams where the MIDI
+    // output can't take SysEx in pieces, so don't reset the board for that
+    if (MidiSerialBridge::canStreamSysExToMidi)
+        onSerialPortChanged(true);
 }
 
 void MainComponent::addMessage(const juce::String& message)
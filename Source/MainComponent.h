@@ -4,11 +4,13 @@
 #include <juce_gui_extra/juce_gui_extra.h>
 #include <juce_audio_devices/juce_audio_devices.h>
 #include "MidiSerialBridge.h"
+#include "SerialPortRegistry.h"
 #include "ModernLookAndFeel.h"
 
 //==============================================================================
 class MainComponent : public juce::Component,
-                      private juce::Timer
+                      private juce::Timer,
+                      private juce::ChangeListener
 {
 public:
     MainComponent();
@@ -20,13 +22,26 @@ public:
 private:
     void timerCallback() override;
     
+    // Serial port hotplug notifications from SerialPortRegistry
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    
+    // Device path for the port selected in serialCombo (empty if none)
+    juce::String getSelectedSerialPortPath();
+    
+    static constexpr const char* loopbackItemName = "Loopback (pty)";
+    
     void refreshSerialPorts();
     void refreshMidiInputs();
     void refreshMidiOutputs();
     
     void onBridgeToggled();
     void onDebugToggled();
-    void onConnectionChanged();
+    void onSerialPortChanged(bool forceReopen = false);
+    void onMidiInputChanged();
+    void onMidiOutputChanged();
+    void onBaudRateChanged();
+    void onLowLatencyToggled();
+    void onSysExStreamingToggled();
 
     // New feature handlers
     void onVelocitySliderChanged(int stringIndex);
@@ -41,6 +56,7 @@ private:
     // UI Components
     juce::Label serialLabel;
     juce::ComboBox serialCombo;
+    juce::ComboBox baudCombo; // editable: any integer rate can be typed in
     
     juce::Label midiInLabel;
     juce::ComboBox midiInCombo;
@@ -49,6 +65,8 @@ private:
     juce::ComboBox midiOutCombo;
     
     juce::ToggleButton bridgeToggle;
+    juce::ToggleButton lowLatencyToggle;
+    juce::ToggleButton sysExStreamingToggle;
     juce::ToggleButton debugToggle;
     
     juce::Label statusLabel;
@@ -112,10 +130,10 @@ private:
     int scrollbackSize;
     int maxDebugMessages;
     
-    // LED blink timers
-    int midiInBlinkCounter;
-    int midiOutBlinkCounter;
-    int serialBlinkCounter;
+    // LED blink timers (set from the bridge's MIDI and serial threads)
+    std::atomic<int> midiInBlinkCounter;
+    std::atomic<int> midiOutBlinkCounter;
+    std::atomic<int> serialBlinkCounter;
     
     static constexpr int LED_BLINK_DURATION = 3; // Timer ticks
 
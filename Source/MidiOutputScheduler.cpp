@@ -0,0 +1,216 @@
+#include "MidiOutputScheduler.h"
+
+// Sleep on the event until this close to the due time, then yield-spin:
+// timed waits overshoot by up to a scheduler tick
+static constexpr double spinMarginMs = 1.5;
+
+//==============================================================================
+class MidiOutputScheduler::ReleaseThread : public juce::Thread
+{
+public:
+    explicit ReleaseThread(MidiOutputScheduler& o)
+        : juce::Thread("MIDI Output Scheduler"), owner(o)
+    {
+    }
+    
+    void run() override
+    {
+        if (! owner.realtimeOptions.isDefault())
+        {
+            auto report = RealtimeThreading::applyToCurrentThread(getThreadName(), owner.realtimeOptions);
+            
+            if (owner.onThreadScheduling)
+                owner.onThreadScheduling(report);
+        }
+        
+        while (! threadShouldExit())
+        {
+            const double nextDueMs = owner.releaseDueMessages();
+            
+            if (nextDueMs == 0.0)
+            {
+                owner.messageQueued.wait(100);
+                continue;
+            }
+            
+            const double remainingMs = nextDueMs - juce::Time::getMillisecondCounterHiRes();
+            
+            if (remainingMs > spinMarginMs)
+                owner.messageQueued.wait(juce::jmax(1, static_cast<int>(remainingMs - spinMarginMs)));
+            else if (remainingMs > 0.0)
+                juce::Thread::yield();
+        }
+    }
+    
+private:
+    MidiOutputScheduler& owner;
+};
+
+//==============================================================================
+MidiOutputScheduler::MidiOutputScheduler()
+{
+}
+
+MidiOutputScheduler::~MidiOutputScheduler()
+{
+    stop();
+}
+
+void MidiOutputScheduler::start(double newDelayMs, int queueSizeBytes)
+{
+    stop();
+    
+    delayMs = juce::jmax(0.0, newDelayMs);
+    lastDueMs = 0.0;
+    
+    const int capacity = juce::jmax(1024, queueSizeBytes);
+    fifo.setTotalSize(capacity);
+    fifo.reset();
+    ring.malloc(static_cast<size_t>(capacity));
+    
+    // Largest message the ring can hold, so a release never needs to allocate
+    releaseBuffer.malloc(static_cast<size_t>(capacity));
+    
+    if (realtimeOptions.lockMemory)
+    {
+        RealtimeThreading::prefault(ring, static_cast<size_t>(capacity));
+        RealtimeThreading::prefault(releaseBuffer, static_cast<size_t>(capacity));
+    }
+    
+    messagesScheduled = 0;
+    messagesReleased = 0;
+    messagesLate = 0;
+    messagesDropped = 0;
+    maxLatenessUs = 0;
+    
+    releaseThread = std::make_unique<ReleaseThread>(*this);
+    releaseThread->startThread(juce::Thread::Priority::highest);
+}
+
+void MidiOutputScheduler::stop()
+{
+    if (releaseThread == nullptr)
+        return;
+    
+    releaseThread->signalThreadShouldExit();
+    messageQueued.signal();
+    releaseThread->stopThread(2000);
+    releaseThread.reset();
+    
+    releaseDueMessages(true);
+}
+
+bool MidiOutputScheduler::isRunning() const
+{
+    return releaseThread != nullptr;
+}
+
+void MidiOutputScheduler::schedule(const juce::uint8* data, int size, double receivedMs)
+{
+    if (releaseThread == nullptr)
+    {
+        if (onRelease)
+            onRelease(data, size, receivedMs);
+        
+        return;
+    }
+    
+    bump(messagesScheduled);
+    
+    const int needed = static_cast<int>(sizeof(Header)) + size;
+    const bool wasEmpty = fifo.getNumReady() == 0;
+    
+    if (fifo.getFreeSpace() < needed)
+    {
+        bump(messagesDropped);
+        return;
+    }
+    
+    // Queue order is release order, so a due time never goes backwards
+    Header header;
+    header.dueMs = juce::jmax(lastDueMs, receivedMs + delayMs);
+    header.size = size;
+    lastDueMs = header.dueMs;
+    
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(needed, start1, size1, start2, size2);
+    
+    writeToRing(start1, &header, static_cast<int>(sizeof(Header)));
+    writeToRing((start1 + static_cast<int>(sizeof(Header))) % fifo.getTotalSize(), data, size);
+    fifo.finishedWrite(needed);
+    
+    // The thread only needs waking when it is idle: anything queued behind
+    // the head is due no earlier than the head
+    if (wasEmpty)
+        messageQueued.signal();
+}
+
+double MidiOutputScheduler::releaseDueMessages(bool releaseAll)
+{
+    for (;;)
+    {
+        if (fifo.getNumReady() < static_cast<int>(sizeof(Header)))
+            return 0.0;
+        
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+        
+        Header header;
+        readFromRing(start1, &header, static_cast<int>(sizeof(Header)));
+        
+        const double now = juce::Time::getMillisecondCounterHiRes();
+        
+        if (header.dueMs > now && ! releaseAll)
+            return header.dueMs;
+        
+        readFromRing((start1 + static_cast<int>(sizeof(Header))) % fifo.getTotalSize(), releaseBuffer, header.size);
+        fifo.finishedRead(static_cast<int>(sizeof(Header)) + header.size);
+        
+        const double latenessMs = now - header.dueMs;
+        
+        if (latenessMs > lateThresholdMs)
+        {
+            bump(messagesLate);
+            
+            const auto latenessUs = static_cast<juce::uint64>(latenessMs * 1000.0);
+            if (latenessUs > maxLatenessUs.load(std::memory_order_relaxed))
+                maxLatenessUs.store(latenessUs, std::memory_order_relaxed);
+        }
+        
+        bump(messagesReleased);
+        
+        if (onRelease)
+            onRelease(releaseBuffer, header.size, header.dueMs - delayMs);
+    }
+}
+
+void MidiOutputScheduler::writeToRing(int position, const void* source, int numBytes)
+{
+    const int capacity = fifo.getTotalSize();
+    const int firstPart = juce::jmin(numBytes, capacity - position);
+    auto* bytes = static_cast<const juce::uint8*>(source);
+    
+    memcpy(ring + position, bytes, static_cast<size_t>(firstPart));
+    memcpy(ring, bytes + firstPart, static_cast<size_t>(numBytes - firstPart));
+}
+
+void MidiOutputScheduler::readFromRing(int position, void* dest, int numBytes) const
+{
+    const int capacity = fifo.getTotalSize();
+    const int firstPart = juce::jmin(numBytes, capacity - position);
+    auto* bytes = static_cast<juce::uint8*>(dest);
+    
+    memcpy(bytes, ring + position, static_cast<size_t>(firstPart));
+    memcpy(bytes + firstPart, ring, static_cast<size_t>(numBytes - firstPart));
+}
+
+MidiOutputScheduler::Stats MidiOutputScheduler::getStats() const
+{
+    Stats stats;
+    stats.messagesScheduled = messagesScheduled.load();
+    stats.messagesReleased = messagesReleased.load();
+    stats.messagesLate = messagesLate.load();
+    stats.messagesDropped = messagesDropped.load();
+    stats.maxLatenessMs = static_cast<double>(maxLatenessUs.load()) * 0.001;
+    return stats;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "RealtimeThreading.h"
+
+/**
+ * MidiOutputScheduler is a jitter buffer for serial -> MIDI traffic. Each
+ * message is queued with the time it arrived and released on a dedicated
+ * high-priority thread at exactly that time plus a fixed delay, so the
+ * output carries a constant offset instead of however long the read and
+ * parse happened to take.
+ *
+ * Messages are released in the order they were scheduled (arrival times
+ * from the serial reader never go backwards). The queue is a byte ring
+ * allocated by start(); schedule() never blocks or allocates.
+ *
+ * Single producer: schedule() must be called from one thread.
+ */
+class MidiOutputScheduler
+{
+public:
+    struct Stats
+    {
+        juce::uint64 messagesScheduled = 0;
+        juce::uint64 messagesReleased = 0;
+        juce::uint64 messagesLate = 0;      // released more than lateThresholdMs after their time
+        juce::uint64 messagesDropped = 0;     // queue full, dropped
+        double maxLatenessMs = 0.0;
+    };
+    
+    MidiOutputScheduler();
+    ~MidiOutputScheduler();
+    
+    // Allocate the queue and start the release thread
+    void start(double delayMs, int queueSizeBytes = 262144);
+    
+    // Stop the thread. Anything still queued is released immediately, so
+    // no note-off is lost.
+    void stop();
+    
+    bool isRunning() const;
+    double getDelayMs() const { return delayMs; }
+    
+    // Queue a message that arrived at receivedMs (getMillisecondCounterHiRes).
+    // If the scheduler isn't running it goes to onRelease on the calling
+    // thread instead. If the queue is full it is counted and dropped: sending
+    // it now would overtake everything still queued, and onRelease would
+    // then run on two threads at once.
+    void schedule(const juce::uint8* data, int size, double receivedMs);
+    
+    // Called on the release thread when a message is due, with the time it
+    // arrived. The data pointer is only valid during the call.
+    std::function<void(const juce::uint8* data, int size, double receivedMs)> onRelease;
+    
+    Stats getStats() const;
+    
+    // Scheduling for the release thread, applied by the next start(). With
+    // lockMemory the queue is prefaulted.
+    void setRealtimeOptions(const RealtimeOptions& options) { realtimeOptions = options; }
+    
+    // Called on the release thread with what it actually got
+    std::function<void(const RealtimeThreading::Report&)> onThreadScheduling;
+    
+    static constexpr double lateThresholdMs = 0.5;
+    
+private:
+    class ReleaseThread;
+    
+    struct Header
+    {
+        double dueMs;
+        int size;
+    };
+    
+    // Release everything due by now (or everything, when stopping); returns
+    // the time the next message is due, or 0 if the queue is empty
+    double releaseDueMessages(bool releaseAll = false);
+    
+    void writeToRing(int position, const void* source, int numBytes);
+    void readFromRing(int position, void* dest, int numBytes) const;
+    
+    // Single writer per counter, so no read-modify-write needed
+    static void bump(std::atomic<juce::uint64>& counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    
+    RealtimeOptions realtimeOptions;
+    double delayMs = 0.0;
+    double lastDueMs = 0.0;     // producer: keeps release times in queue order
+    juce::AbstractFifo fifo { 1 };
+    juce::HeapBlock<juce::uint8> ring;
+    juce::HeapBlock<juce::uint8> releaseBuffer;
+    juce::WaitableEvent messageQueued;
+    std::unique_ptr<ReleaseThread> releaseThread;
+    
+    std::atomic<juce::uint64> messagesScheduled { 0 };
+    std::atomic<juce::uint64> messagesReleased { 0 };
+    std::atomic<juce::uint64> messagesLate { 0 };
+    std::atomic<juce::uint64> messagesDropped { 0 };
+    std::atomic<juce::uint64> maxLatenessUs { 0 };
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiOutputScheduler)
+};
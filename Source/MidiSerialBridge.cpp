@@ -1,27 +1,100 @@
 #include "MidiSerialBridge.h"
 
-MidiSerialBridge::MidiSerialBridge()
-    : runningStatus(0)
-    , dataExpected(0)
-    , attachTime(juce::Time::getCurrentTime())
+//==============================================================================
+// Consumes the serial receive ring so that parsing and MIDI output never
+// hold up the thread that reads from the port
+class MidiSerialBridge::SerialDispatchThread : public juce::Thread
 {
-    // Defaults: all velocity scales at 10 (unity)
-    for (int i = 0; i < 6; ++i)
+public:
+    explicit SerialDispatchThread(MidiSerialBridge& o)
+        : juce::Thread("Serial Dispatch"), owner(o)
+    {
+    }
+    
+    void run() override
+    {
+        owner.applyRealtimeOptions(getThreadName());
+        
+        while (! threadShouldExit())
+        {
+            dataPending.wait(100);
+            
+            if (threadShouldExit())
+                break;
+            
+            owner.processSerialData();
+        }
+    }
+    
+    void notifyDataPending() { dataPending.signal(); }
+    
+    void stop()
     {
-        stringVelocityScale[i] = 10;
-        octaveShift[i] = 0;
-        semitoneShift[i] = 0;
+        signalThreadShouldExit();
+        dataPending.signal();
+        stopThread(2000);
     }
-    unifiedChannel = 1; // single output channel
-    globalOctaveShift = 0;
-    rootNotePc = 0; // C
-    for (int i = 0; i < 12; ++i)
-        diatonicMask[i] = true; // initially allow all notes (chromatic)
+    
+private:
+    MidiSerialBridge& owner;
+    juce::WaitableEvent dataPending;
+};
+
+//==============================================================================
+// Watches the serial session and brings it back after I/O errors, without
+// touching the MIDI endpoints
+class MidiSerialBridge::SerialSupervisorThread : public juce::Thread
+{
+public:
+    explicit SerialSupervisorThread(MidiSerialBridge& o)
+        : juce::Thread("Serial Supervisor"), owner(o)
+    {
+    }
+    
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            failure.wait(500);
+            
+            if (! threadShouldExit() && owner.serialPort.hasFailed())
+                owner.recoverSerialSession(*this);
+        }
+    }
+    
+    void notifyFailure() { failure.signal(); }
+    
+private:
+    MidiSerialBridge& owner;
+    juce::WaitableEvent failure;
+};
+
+//==============================================================================
+MidiSerialBridge::MidiSerialBridge()
+    : attachTimeMs(juce::Time::getMillisecondCounterHiRes())
+{
+    serialParser.onMessage = [this](const juce::uint8* data, int size) { handleSerialMessage(data, size); };
+    serialParser.onDebugText = [this](const char* text, int length) { handleSerialDebugText(text, length); };
+    serialParser.onRealtimeMessage = [this](juce::uint8 byte) { handleSerialRealtime(byte); };
+    serialParser.onSysExChunk = [this](const juce::uint8* data, int size, bool isLast)
+    {
+        handleSerialSysExChunk(data, size, isLast);
+    };
+    outputScheduler.onRelease = [this](const juce::uint8* data, int size, double receivedMs)
+    {
+        releaseSerialMessage(data, size, receivedMs);
+    };
+    serialPort.onThreadScheduling = [this](const RealtimeThreading::Report& report) { reportThreadScheduling(report); };
+    serialPort.setTrafficCapture(&capture);
+    outputScheduler.onThreadScheduling = [this](const RealtimeThreading::Report& report) { reportThreadScheduling(report); };
+    
+    publishConfig();
 }
 
 MidiSerialBridge::~MidiSerialBridge()
 {
     detach();
+    delete activeConfig.exchange(nullptr);
 }
 
 void MidiSerialBridge::attach(const juce::String& serialPortName,
@@ -30,153 +103,599 @@ void MidiSerialBridge::attach(const juce::String& serialPortName,
 {
     detach();
     
-    attachTime = juce::Time::getCurrentTime();
+    attachTimeMs = juce::Time::getMillisecondCounterHiRes();
+    
+    setSerialPort(serialPortName);
+    setMidiInput(midiInputName);
+    setMidiOutput(midiOutputName);
+}
+
+void MidiSerialBridge::detach()
+{
+    if (onDisplayMessage)
+        onDisplayMessage(applyTimeStamp("Closing MIDI<->Serial bridge..."));
+    
+    // MIDI input first, so the notes it left sounding can still be released
+    // on the serial port; then the serial side (the dispatch thread sends
+    // to midiOutput); the MIDI output last
+    setMidiInput({});
+    setSerialPort({});
+    setMidiOutput({});
+}
+
+bool MidiSerialBridge::setSerialPort(const juce::String& serialPortName, bool forceReopen)
+{
+    if (! forceReopen && serialPort.isOpen() && serialPortName == serialPort.getPortName())
+        return true; // unchanged: don't reset the board
+    
+    stopSerialSupervisor();
     
-    // Open serial port
-    if (serialPortName.isNotEmpty())
     {
-        if (onDisplayMessage)
-            onDisplayMessage("Opening serial port '" + serialPortName + "'...");
-        
-        if (serialPort.openPort(serialPortName, 115200))
-        {
-            if (onDisplayMessage)
-                onDisplayMessage("Serial port opened successfully");
-            
-            // Start timer to poll serial data (20ms intervals)
-            startTimer(20);
-        }
-        else
-        {
-            if (onDisplayMessage)
-                onDisplayMessage("Failed to open serial port '" + serialPortName + "'");
-        }
+        const juce::ScopedLock sl(serialSessionLock);
+        closeSerialSession();
     }
     
-    // Open MIDI input
-    if (midiInputName.isNotEmpty())
+    if (serialPortName.isEmpty())
+        return true;
+    
+    serialPort.resetTxStats();
+    serialPort.resetRxStats();
+    
+    // Connect outside the lock, then swap the session in
+    auto transport = connectSerialPort(serialPortName);
+    
+    if (transport == nullptr)
+        return false;
+    
     {
-        auto devices = juce::MidiInput::getAvailableDevices();
+        const juce::ScopedLock sl(serialSessionLock);
         
-        for (auto& device : devices)
+        if (! openSerialSession(std::move(transport), serialPortName))
+            return false;
+    }
+    
+    rememberSerialIdentity(serialPortName);
+    return true;
+}
+
+bool MidiSerialBridge::setMidiInput(const juce::String& newInputName)
+{
+    if (midiInput != nullptr && newInputName == midiInputName)
+        return true;
+    
+    std::unique_ptr<juce::MidiInput> newInput;
+    
+    if (newInputName.isNotEmpty())
+    {
+        for (auto& device : juce::MidiInput::getAvailableDevices())
         {
-            if (device.name == midiInputName)
+            if (device.name == newInputName)
             {
                 if (onDisplayMessage)
-                    onDisplayMessage("Opening MIDI Input '" + midiInputName + "'...");
-                
-                midiInput = juce::MidiInput::openDevice(device.identifier, this);
-                
-                if (midiInput != nullptr)
-                {
-                    midiInput->start();
-                    this->midiInputName = midiInputName;
-                    
-                    if (onDisplayMessage)
-                        onDisplayMessage("MIDI Input opened successfully");
-                }
-                else
-                {
-                    if (onDisplayMessage)
-                        onDisplayMessage("Failed to open MIDI Input");
-                }
+                    onDisplayMessage("Opening MIDI Input '" + newInputName + "'...");
                 
+                newInput = juce::MidiInput::openDevice(device.identifier, this);
                 break;
             }
         }
+        
+        if (newInput == nullptr)
+        {
+            if (onDisplayMessage)
+                onDisplayMessage("Failed to open MIDI Input");
+            return false;
+        }
+        
+        if (onDisplayMessage)
+            onDisplayMessage("MIDI Input opened successfully");
     }
     
-    // Open MIDI output
-    if (midiOutputName.isNotEmpty())
+    // Stop the old input before starting the new one: the transmit queue
+    // and the SysEx bookkeeping take one MIDI callback thread at a time.
+    // The new device is already open, so the gap is only the hand-over.
+    if (midiInput != nullptr)
     {
-        auto devices = juce::MidiOutput::getAvailableDevices();
-        
-        for (auto& device : devices)
+        midiInput->stop();
+        releaseMidiInputNotes();
+    }
+    
+    midiSysExBytesQueued = 0;
+    midiSysExBytesCaptured = 0;
+    
+    if (newInput != nullptr)
+        newInput->start();
+    
+    midiInput = std::move(newInput);
+    midiInputName = midiInput != nullptr ? newInputName : juce::String();
+    return true;
+}
+
+bool MidiSerialBridge::setMidiOutput(const juce::String& newOutputName)
+{
+    if (midiOutput != nullptr && newOutputName == midiOutputName)
+        return true;
+    
+    std::unique_ptr<juce::MidiOutput> newOutput;
+    
+    if (newOutputName.isNotEmpty())
+    {
+        for (auto& device : juce::MidiOutput::getAvailableDevices())
         {
-            if (device.name == midiOutputName)
+            if (device.name == newOutputName)
             {
                 if (onDisplayMessage)
-                    onDisplayMessage("Opening MIDI Output '" + midiOutputName + "'...");
-                
-                midiOutput = juce::MidiOutput::openDevice(device.identifier);
-                
-                if (midiOutput != nullptr)
-                {
-                    this->midiOutputName = midiOutputName;
-                    
-                    if (onDisplayMessage)
-                        onDisplayMessage("MIDI Output opened successfully");
-                }
-                else
-                {
-                    if (onDisplayMessage)
-                        onDisplayMessage("Failed to open MIDI Output");
-                }
+                    onDisplayMessage("Opening MIDI Output '" + newOutputName + "'...");
                 
+                newOutput = juce::MidiOutput::openDevice(device.identifier);
                 break;
             }
         }
+        
+        if (newOutput == nullptr)
+        {
+            if (onDisplayMessage)
+                onDisplayMessage("Failed to open MIDI Output");
+            return false;
+        }
+        
+        if (onDisplayMessage)
+            onDisplayMessage("MIDI Output opened successfully");
     }
+    
+    // Publish the new output, then wait for senders still using the old one
+    activeMidiOutput.store(newOutput.get());
+    
+    while (midiOutputUsers.load() > 0)
+        juce::Thread::yield();
+    
+    midiOutput = std::move(newOutput);
+    midiOutputName = midiOutput != nullptr ? newOutputName : juce::String();
+    return true;
 }
 
-void MidiSerialBridge::detach()
+bool MidiSerialBridge::sendToMidiOutput(const juce::MidiMessage& message)
 {
-    stopTimer();
+    // Lock-free: the counter keeps setMidiOutput from deleting the output under us
+    ++midiOutputUsers;
+    
+    auto* output = activeMidiOutput.load();
     
+    if (output != nullptr)
+    {
+        output->sendMessageNow(message);
+        capture.write(TrafficCapture::Source::midi, TrafficCapture::Direction::out, juce::Time::getMillisecondCounterHiRes(),
+                      message.getRawData(), message.getRawDataSize());
+    }
+    
+    --midiOutputUsers;
+    return output != nullptr;
+}
+
+void MidiSerialBridge::releaseMidiInputNotes()
+{
+    midiNoteStates.forEachSoundingNote([this](int outChannel0, int outNote)
+    {
+        const auto noteOff = juce::MidiMessage::noteOff(outChannel0 + 1, outNote);
+        
+        if (serialPort.isOpen())
+            serialPort.queueWrite(noteOff.getRawData(), noteOff.getRawDataSize());
+        
+        sendToMidiOutput(noteOff);
+    });
+    
+    midiNoteStates.clear();
+}
+
+void MidiSerialBridge::releaseSerialNotes()
+{
+    serialNoteStates.forEachSoundingNote([this](int outChannel0, int outNote)
+    {
+        sendToMidiOutput(juce::MidiMessage::noteOff(outChannel0 + 1, outNote));
+    });
+    
+    serialNoteStates.clear();
+}
+
+std::unique_ptr<SerialTransport> MidiSerialBridge::connectSerialPort(const juce::String& serialPortName)
+{
     if (onDisplayMessage)
-        onDisplayMessage(applyTimeStamp("Closing MIDI<->Serial bridge..."));
+        onDisplayMessage("Opening serial port '" + serialPortName + "' at "
+                         + juce::String(serialBaudRate) + " baud...");
+    
+    auto transport = serialPort.createTransport(serialPortName, serialBaudRate);
+    
+    if (transport == nullptr && onDisplayMessage)
+        onDisplayMessage("Failed to open serial port '" + serialPortName + "'");
+    
+    return transport;
+}
+
+bool MidiSerialBridge::openSerialSession(std::unique_ptr<SerialTransport> transport, const juce::String& serialPortName)
+{
+    if (! serialPort.openTransport(std::move(transport), serialPortName))
+        return false;
+    
+    if (onDisplayMessage)
+        onDisplayMessage("Serial port opened successfully ("
+                         + juce::String(serialPort.getBaudRate()) + " baud)");
+    
+    if (serialPort.getPseudoTerminalPath().isNotEmpty() && onDisplayMessage)
+        onDisplayMessage("Loopback pty ready at " + serialPort.getPseudoTerminalPath());
+    
+    auto latency = serialPort.getLowLatencyStatus();
+    if (latency.requested && onDisplayMessage)
+        onDisplayMessage(juce::String::formatted(
+            "Low latency: ASYNC_LOW_LATENCY %s, VMIN %d, VTIME %d, latency timer %s",
+            latency.asyncLowLatency ? "on" : "off",
+            latency.vmin,
+            latency.vtime,
+            latency.latencyTimerMs >= 0 ? (juce::String(latency.latencyTimerMs) + " ms").toRawUTF8()
+                                        : "n/a"));
+    
+    serialParser.setSysExStreaming(sysExStreaming && canStreamSysExToMidi, sysExChunkSize);
+    
+    if (sysExStreaming && ! canStreamSysExToMidi && onDisplayMessage)
+        onDisplayMessage(juce::String::formatted("SysEx streaming: MIDI -> serial only; serial SysEx is forwarded "
+                                                 "whole (up to %d bytes), ALSA can't send it in pieces",
+                                                 serialParser.getMaxSysExSize()));
+    
+    serialLatencyMessages = 0;
+    serialLatencyTotalUs = 0;
+    serialLatencyMaxUs = 0;
     
-    if (midiInput != nullptr)
     {
-        midiInput->stop();
-        midiInput.reset();
+        const juce::ScopedLock sl(threadReportLock);
+        threadReports.clear();
+    }
+    
+    if (realtimeOptions.lockMemory && ! memoryLocked)
+    {
+        juce::String error;
+        memoryLocked = RealtimeThreading::lockProcessMemory(error);
+        
+        if (onDisplayMessage)
+            onDisplayMessage(memoryLocked ? juce::String("Process memory locked")
+                                          : "Could not lock process memory: " + error);
+    }
+    
+    if (outputDelayMs > 0.0)
+    {
+        outputScheduler.start(outputDelayMs);
+        
+        if (onDisplayMessage)
+            onDisplayMessage(juce::String::formatted("Fixed output latency: %.1f ms", outputDelayMs));
+    }
+    
+    // The reader thread only fills the ring; parsing happens on the
+    // dispatch thread as soon as it is woken
+    serialDispatchThread = std::make_unique<SerialDispatchThread>(*this);
+    serialDispatchThread->startThread(juce::Thread::Priority::high);
+    
+    serialPort.onDataAvailable = [this]()
+    {
+        serialDispatchThread->notifyDataPending();
+    };
+    
+    // I/O errors hand the session over to the supervisor
+    serialPort.onError = [this](const juce::String& reason)
+    {
+        if (onDisplayMessage)
+            onDisplayMessage(applyTimeStamp(reason + ", serial connection lost"));
+        
+        if (serialSupervisorThread != nullptr)
+            serialSupervisorThread->notifyFailure();
+    };
+    
+    serialPort.startReading();
+    
+    if (autoReconnect)
+        startSerialSupervisor();
+    
+    return true;
+}
+
+void MidiSerialBridge::closeSerialSession()
+{
+    if (serialPort.isOpen())
+    {
+        serialPort.stopReading();
+        
+        if (serialDispatchThread != nullptr)
+        {
+            serialDispatchThread->stop();
+            serialDispatchThread.reset();
+        }
+        
+        // Nothing more will be scheduled; flush what is still held back
+        if (outputScheduler.isRunning())
+        {
+            outputScheduler.stop();
+            
+            auto schedulerStats = outputScheduler.getStats();
+            if (onDisplayMessage)
+                onDisplayMessage(applyTimeStamp(juce::String::formatted(
+                    "Output scheduler: %llu messages, %llu late (max %.3f ms), %llu dropped (queue full)",
+                    (unsigned long long) schedulerStats.messagesScheduled,
+                    (unsigned long long) schedulerStats.messagesLate,
+                    schedulerStats.maxLatenessMs,
+                    (unsigned long long) schedulerStats.messagesDropped)));
+        }
+        
+        // The board is gone or being replaced: don't leave its notes sounding
+        releaseSerialNotes();
+        
+        serialPort.closePort();
+        
+        auto stats = serialPort.getTxStats();
+        if (onDisplayMessage)
+            onDisplayMessage(applyTimeStamp(juce::String::formatted(
+                "Serial TX: %llu bytes queued (+%llu real-time), %llu written, %llu dropped",
+                (unsigned long long) stats.bytesQueued,
+                (unsigned long long) stats.realtimeBytesQueued,
+                (unsigned long long) stats.bytesWritten,
+                (unsigned long long) stats.bytesDropped)));
+        
+        auto rxStats = serialPort.getRxStats();
+        if (onDisplayMessage)
+            onDisplayMessage(applyTimeStamp(juce::String::formatted(
+                "Serial RX: %llu bytes received, ring high-water %d of %d bytes",
+                (unsigned long long) rxStats.bytesReceived,
+                rxStats.highWaterMark,
+                rxStats.capacity)));
+        
+        auto latency = getSerialLatencyStats();
+        if (onDisplayMessage && latency.messages > 0)
+            onDisplayMessage(applyTimeStamp(juce::String::formatted(
+                "Serial -> MIDI latency: %.3f ms average, %.3f ms max over %llu messages",
+                latency.averageMs,
+                latency.maxMs,
+                (unsigned long long) latency.messages)));
+        
+        auto parserStats = serialParser.getStats();
+        if (onDisplayMessage)
+            onDisplayMessage(applyTimeStamp(juce::String::formatted(
+                "Serial parser: %llu messages, %llu SysEx, %llu real-time, %llu incomplete, "
+                "%llu stray data bytes, %llu unknown status bytes, %llu SysEx overflows",
+                (unsigned long long) parserStats.messages,
+                (unsigned long long) parserStats.sysExMessages,
+                (unsigned long long) parserStats.realtimeMessages,
+                (unsigned long long) parserStats.incompleteMessages,
+                (unsigned long long) parserStats.unexpectedDataBytes,
+                (unsigned long long) parserStats.unknownStatusBytes,
+                (unsigned long long) parserStats.sysExOverflows)));
+    }
+    
+    serialPort.onDataAvailable = nullptr;
+    serialPort.onError = nullptr;
+    
+    // A new session starts with a clean parser: no half message, no running status
+    resetParserState();
+}
+
+void MidiSerialBridge::resetParserState()
+{
+    serialParser.reset();
+}
+
+void MidiSerialBridge::rememberSerialIdentity(const juce::String& serialPortName)
+{
+    serialIdentity = SerialPortRegistry::PortInfo();
+    serialIdentity.portName = serialPortName;
+    
+    SerialPortRegistry::PortInfo info;
+    if (SerialPortRegistry::getInstance()->findByPortName(serialPortName, info))
+        serialIdentity = info;
+}
+
+juce::String MidiSerialBridge::findSerialPortForReconnect()
+{
+    // Network and replay transports aren't enumerated: just retry the same name
+    if (! SerialTransport::isDevicePortName(serialIdentity.portName))
+        return serialIdentity.portName;
+    
+    auto& registry = *SerialPortRegistry::getInstance();
+    
+    // The hotplug monitor may not be running (e.g. headless), so rescan
+    registry.refresh();
+    
+    SerialPortRegistry::PortInfo info;
+    
+    if (registry.findByStableId(serialIdentity.stableId, info))
+        return info.portName;
+    
+    // Same USB device (VID/PID/serial number) under a new tty name
+    if (serialIdentity.vendorId != 0)
+    {
+        for (auto& port : registry.getPorts())
+            if (port.vendorId == serialIdentity.vendorId
+                && port.productId == serialIdentity.productId
+                && port.serialNumber == serialIdentity.serialNumber)
+                return port.portName;
+    }
+    
+    if (registry.findByPortName(serialIdentity.portName, info))
+        return info.portName;
+    
+    return {};
+}
+
+bool MidiSerialBridge::recoverSerialSession(juce::Thread& supervisor)
+{
+    {
+        const juce::ScopedLock sl(serialSessionLock);
+        closeSerialSession();
     }
     
-    midiOutput.reset();
-    serialPort.closePort();
+    // Exponential backoff: 100 ms, 200 ms ... capped at 5 s
+    int delayMs = 100;
     
-    runningStatus = 0;
-    dataExpected = 0;
-    messageData.reset();
+    while (! supervisor.threadShouldExit())
+    {
+        supervisor.wait(delayMs);
+        
+        if (supervisor.threadShouldExit())
+            break;
+        
+        juce::String portName = findSerialPortForReconnect();
+        
+        // The (possibly slow) connect happens outside the lock, so a port
+        // change or detach never waits on it for long
+        auto transport = portName.isNotEmpty() ? connectSerialPort(portName) : nullptr;
+        
+        if (transport != nullptr)
+        {
+            const juce::ScopedLock sl(serialSessionLock);
+            
+            if (! supervisor.threadShouldExit() && openSerialSession(std::move(transport), portName))
+            {
+                if (onDisplayMessage)
+                    onDisplayMessage(applyTimeStamp("Serial reconnected on '" + portName + "'"));
+                return true;
+            }
+        }
+        
+        delayMs = juce::jmin(delayMs * 2, 5000);
+    }
+    
+    return false;
+}
+
+void MidiSerialBridge::startSerialSupervisor()
+{
+    if (serialSupervisorThread == nullptr)
+        serialSupervisorThread = std::make_unique<SerialSupervisorThread>(*this);
+    
+    if (! serialSupervisorThread->isThreadRunning())
+        serialSupervisorThread->startThread(juce::Thread::Priority::normal);
+}
+
+// The thread object stays allocated: onError may still look at it until the
+// reader thread has been stopped. Never killed: the longest it can be busy
+// is one transport connect (bounded by the tcp:// connect timeout).
+void MidiSerialBridge::stopSerialSupervisor()
+{
+    if (serialSupervisorThread != nullptr)
+    {
+        serialSupervisorThread->signalThreadShouldExit();
+        serialSupervisorThread->notify();
+        serialSupervisorThread->waitForThreadToExit(-1);
+    }
 }
 
 void MidiSerialBridge::handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message)
 {
     juce::ignoreUnused(source);
     
-    if (onDebugMessage)
-        onDebugMessage(applyTimeStamp("MIDI In: " + describeMidiMessage(message)));
+    // Streamed SysEx is captured piece by piece as it arrives
+    if (! (sysExStreaming && message.isSysEx()))
+        capture.write(TrafficCapture::Source::midi, TrafficCapture::Direction::in, message.getTimeStamp() * 1000.0,
+                      message.getRawData(), message.getRawDataSize());
+    
+    // Real-time bytes skip the transform and jump the serial transmit queue
+    if (message.getRawDataSize() == 1 && MidiStreamParser::isRealtimeByte(message.getRawData()[0]))
+    {
+        const juce::uint8 byte = message.getRawData()[0];
+        
+        if (serialPort.isOpen())
+            serialPort.queueRealtimeByte(byte);
+        
+        if (sendToMidiOutput(message) && onMidiSent)
+            onMidiSent();
+        
+        if (onMidiReceived)
+            onMidiReceived();
+        
+        if (! isHighRateRealtime(byte))
+            logDebug(BridgeLog::Event::midiIn, message.getTimeStamp() * 1000.0, &byte, 1);
+        
+        return;
+    }
+    
+    // The start of this SysEx already went out from handlePartialSysexMessage;
+    // queue the rest and loop the whole message back
+    if (sysExStreaming && message.isSysEx())
+    {
+        const int size = message.getRawDataSize();
+        const int alreadyQueued = juce::jmin(midiSysExBytesQueued, size);
+        const int alreadyCaptured = juce::jmin(midiSysExBytesCaptured, size);
+        midiSysExBytesQueued = 0;
+        midiSysExBytesCaptured = 0;
+        
+        capture.write(TrafficCapture::Source::midi, TrafficCapture::Direction::in, message.getTimeStamp() * 1000.0,
+                      message.getRawData() + alreadyCaptured, size - alreadyCaptured);
+        
+        if (serialPort.isOpen())
+        {
+            serialPort.queueWrite(message.getRawData() + alreadyQueued, size - alreadyQueued);
+            if (onSerialTraffic)
+                onSerialTraffic();
+        }
+        
+        if (onMidiReceived)
+            onMidiReceived();
+        
+        logDebug(BridgeLog::Event::midiInSysEx, message.getTimeStamp() * 1000.0, message.getRawData(), size);
+        
+        if (sendToMidiOutput(message) && onMidiSent)
+            onMidiSent();
+        
+        return;
+    }
+    
+    logDebug(BridgeLog::Event::midiIn, message.getTimeStamp() * 1000.0, message.getRawData(), message.getRawDataSize());
     
     if (onMidiReceived)
         onMidiReceived();
     
     juce::MidiMessage transformed(message);
-    if (! processOutgoingMessage(message, transformed))
+    if (! processOutgoingMessage(midiNoteStates, message, transformed))
         return; // filtered out
+    
+    transformed.setTimeStamp(message.getTimeStamp());
 
-    // Send to serial port
+    // Queue for the serial writer thread; never blocks the MIDI callback
     if (serialPort.isOpen())
     {
-        serialPort.write(transformed.getRawData(), transformed.getRawDataSize());
+        serialPort.queueWrite(transformed.getRawData(), transformed.getRawDataSize());
         if (onSerialTraffic)
             onSerialTraffic();
     }
 
     // Send to MIDI output (loopback to DAW)
-    if (midiOutput != nullptr)
+    if (sendToMidiOutput(transformed))
     {
-        midiOutput->sendMessageNow(transformed);
         if (onMidiSent)
             onMidiSent();
     }
 }
 
-void MidiSerialBridge::timerCallback()
+void MidiSerialBridge::handlePartialSysexMessage(juce::MidiInput* source, const juce::uint8* messageData,
+                                                 int numBytesSoFar, double timestamp)
 {
-    // Poll serial port for data
-    if (serialPort.bytesAvailable() > 0)
+    juce::ignoreUnused(source);
+    
+    if (! sysExStreaming)
+        return;
+    
+    // JUCE passes everything received so far; only the new tail goes out.
+    // A smaller count than last time is a new message.
+    if (numBytesSoFar < midiSysExBytesCaptured)
     {
-        processSerialData();
+        midiSysExBytesQueued = 0;
+        midiSysExBytesCaptured = 0;
+    }
+    
+    capture.write(TrafficCapture::Source::midi, TrafficCapture::Direction::in, timestamp * 1000.0,
+                  messageData + midiSysExBytesCaptured, numBytesSoFar - midiSysExBytesCaptured);
+    midiSysExBytesCaptured = numBytesSoFar;
+    
+    // Only bytes that were really queued count as sent: if the port is
+    // closed or the queue is full, they go out with a later piece (or the
+    // whole message), so the serial side never gets a tail without its F0
+    if (serialPort.isOpen() && numBytesSoFar > midiSysExBytesQueued
+         && serialPort.queueWrite(messageData + midiSysExBytesQueued, numBytesSoFar - midiSysExBytesQueued))
+    {
+        midiSysExBytesQueued = numBytesSoFar;
         
         if (onSerialTraffic)
             onSerialTraffic();
@@ -185,178 +704,227 @@ void MidiSerialBridge::timerCallback()
 
 void MidiSerialBridge::processSerialData()
 {
-    juce::uint8 buffer[1024];
-    int bytesRead = serialPort.read(buffer, sizeof(buffer));
-    
-    for (int i = 0; i < bytesRead; ++i)
+    // Consume the ring in whole spans until the reader stops adding to it
+    for (;;)
     {
-        juce::uint8 nextByte = buffer[i];
+        auto spans = serialPort.getReceivedData();
+        const int total = spans.getTotalSize();
         
-        if (nextByte & STATUS_MASK)
-            onStatusByte(nextByte);
-        else
-            onDataByte(nextByte);
+        if (total == 0)
+            break;
+        
+        serialParser.setStreamPosition(spans.position);
+        serialParser.parse(spans.data1, spans.size1);
+        serialParser.parse(spans.data2, spans.size2);
+        serialPort.finishedReading(total);
         
-        if (dataExpected == 0)
-            sendMidiMessage();
+        if (onSerialTraffic)
+            onSerialTraffic();
     }
 }
 
-void MidiSerialBridge::onStatusByte(juce::uint8 byte)
+double MidiSerialBridge::serialMessageTime()
 {
-    // Handle SysEx end
-    if (byte == MSG_SYSEX_END && messageData.getSize() > 0)
-    {
-        const juce::uint8* data = static_cast<const juce::uint8*>(messageData.getData());
-        if (data[0] == MSG_SYSEX_START)
-        {
-            messageData.append(&byte, 1);
-            sendMidiMessage();
-            return;
-        }
-    }
+    return serialPort.getArrivalTime(serialParser.getMessagePosition());
+}
+
+void MidiSerialBridge::recordSerialLatency(double receivedMs)
+{
+    const double latencyMs = juce::Time::getMillisecondCounterHiRes() - receivedMs;
+    const auto latencyUs = static_cast<juce::uint64>(juce::jmax(0.0, latencyMs * 1000.0));
     
-    // If we were expecting more data, send incomplete message with warning
-    if (dataExpected > 0)
-    {
-        if (onDisplayMessage)
-        {
-            juce::String msg = juce::String::formatted(
-                "Warning: got a status byte when we were expecting %d more data bytes, "
-                "sending possibly incomplete MIDI message 0x%02X",
-                dataExpected,
-                static_cast<const juce::uint8*>(messageData.getData())[0]);
-            onDisplayMessage(applyTimeStamp(msg));
-        }
-        sendMidiMessage();
-    }
+    // Single writer: the dispatch thread, or the scheduler's release thread
+    serialLatencyMessages.store(serialLatencyMessages.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    serialLatencyTotalUs.store(serialLatencyTotalUs.load(std::memory_order_relaxed) + latencyUs, std::memory_order_relaxed);
     
-    // Update running status
-    if (isVoiceMessage(byte))
-        runningStatus = byte;
-    if (isSysCommonMessage(byte))
-        runningStatus = 0;
+    if (latencyUs > serialLatencyMaxUs.load(std::memory_order_relaxed))
+        serialLatencyMaxUs.store(latencyUs, std::memory_order_relaxed);
+}
+
+MidiSerialBridge::LatencyStats MidiSerialBridge::getSerialLatencyStats() const
+{
+    LatencyStats stats;
+    stats.messages = serialLatencyMessages.load();
+    stats.maxMs = static_cast<double>(serialLatencyMaxUs.load()) * 0.001;
     
-    dataExpected = getDataLength(byte);
+    if (stats.messages > 0)
+        stats.averageMs = static_cast<double>(serialLatencyTotalUs.load()) * 0.001 / static_cast<double>(stats.messages);
     
-    if (dataExpected == -2) // UNKNOWN_MIDI
-    {
-        if (onDisplayMessage)
-        {
-            juce::String msg = juce::String::formatted("Warning: got unexpected status byte 0x%02X", byte);
-            onDisplayMessage(applyTimeStamp(msg));
-        }
-        dataExpected = 0;
-    }
+    return stats;
+}
+
+bool MidiSerialBridge::startCapture(const juce::File& file, juce::String& errorMessage)
+{
+    if (! capture.start(file, errorMessage))
+        return false;
+    
+    if (onDisplayMessage)
+        onDisplayMessage(applyTimeStamp("Capturing traffic to " + file.getFullPathName()));
+    
+    return true;
+}
+
+void MidiSerialBridge::stopCapture()
+{
+    if (! capture.isRunning())
+        return;
+    
+    capture.stop();
     
-    messageData.reset();
-    messageData.append(&byte, 1);
+    const auto stats = capture.getStats();
+    
+    if (onDisplayMessage)
+        onDisplayMessage(applyTimeStamp(juce::String::formatted("Capture saved: %llu records, %llu bytes, %llu dropped",
+                                                                (unsigned long long) stats.recordsWritten,
+                                                                (unsigned long long) stats.bytesWritten,
+                                                                (unsigned long long) stats.recordsDropped)));
+}
+
+void MidiSerialBridge::setRealtimeOptions(const RealtimeOptions& options)
+{
+    realtimeOptions = options;
+    serialPort.setRealtimeOptions(options);
+    outputScheduler.setRealtimeOptions(options);
 }
 
-void MidiSerialBridge::onDataByte(juce::uint8 byte)
+void MidiSerialBridge::applyRealtimeOptions(const juce::String& threadName)
+{
+    if (! realtimeOptions.isDefault())
+        reportThreadScheduling(RealtimeThreading::applyToCurrentThread(threadName, realtimeOptions));
+}
+
+void MidiSerialBridge::reportThreadScheduling(const RealtimeThreading::Report& report)
 {
-    // Handle running status
-    if (dataExpected == 0 && runningStatus != 0)
     {
-        onStatusByte(runningStatus);
+        const juce::ScopedLock sl(threadReportLock);
+        threadReports.add(report);
     }
     
-    if (dataExpected == 0)
+    if (onDisplayMessage && report.description.isNotEmpty())
+        onDisplayMessage(applyTimeStamp(report.threadName + (report.isOk() ? ": " : " (not as requested): ")
+                                        + report.description));
+}
+
+juce::Array<RealtimeThreading::Report> MidiSerialBridge::getThreadSchedulingReports() const
+{
+    const juce::ScopedLock sl(threadReportLock);
+    return threadReports;
+}
+
+void MidiSerialBridge::releaseSerialMessage(const juce::uint8* data, int size, double receivedMs)
+{
+    if (sendToMidiOutput(juce::MidiMessage(data, size, receivedMs * 0.001)))
     {
-        if (onDisplayMessage)
-        {
-            juce::String msg = juce::String::formatted("Error: got unexpected data byte 0x%02X", byte);
-            onDisplayMessage(applyTimeStamp(msg));
-        }
-        return;
+        recordSerialLatency(receivedMs);
+        
+        if (onMidiSent)
+            onMidiSent();
     }
+}
+
+void MidiSerialBridge::handleSerialMessage(const juce::uint8* data, int size)
+{
+    // MidiMessage timestamps are in seconds on the same clock as MidiInput's
+    const double receivedMs = serialMessageTime();
     
-    messageData.append(&byte, 1);
-    dataExpected--;
+    logDebug(BridgeLog::Event::serialIn, receivedMs, data, size);
     
-    // Handle debug message length
-    const juce::uint8* data = static_cast<const juce::uint8*>(messageData.getData());
-    if (data[0] == MSG_DEBUG && dataExpected == 0 && messageData.getSize() == 4)
+    // Send to MIDI output
+    if (activeMidiOutput.load() != nullptr)
     {
-        dataExpected += data[3]; // Add message length
+        juce::MidiMessage msg(data, size, receivedMs * 0.001);
+        juce::MidiMessage transformed(msg);
+        if (processOutgoingMessage(serialNoteStates, msg, transformed))
+            outputScheduler.schedule(transformed.getRawData(), transformed.getRawDataSize(), receivedMs);
     }
 }
 
-void MidiSerialBridge::sendMidiMessage()
+void MidiSerialBridge::handleSerialRealtime(juce::uint8 byte)
 {
-    if (messageData.getSize() == 0)
-        return;
+    const double receivedMs = serialMessageTime();
     
-    const juce::uint8* data = static_cast<const juce::uint8*>(messageData.getData());
+    // Straight out, ahead of whatever message it interrupted (with the
+    // scheduler on, clock ticks keep the same fixed offset as the notes)
+    if (activeMidiOutput.load() != nullptr)
+        outputScheduler.schedule(&byte, 1, receivedMs);
+    
+    if (! isHighRateRealtime(byte))
+        logDebug(BridgeLog::Event::serialIn, receivedMs, &byte, 1);
+}
+
+void MidiSerialBridge::handleSerialSysExChunk(const juce::uint8* data, int size, bool isLast)
+{
+    // A chunk is a raw byte run, not a complete message; the MIDI driver
+    // stitches the pieces back together on the wire
+    const double receivedMs = serialMessageTime();
+    
+    if (activeMidiOutput.load() != nullptr)
+        outputScheduler.schedule(data, size, receivedMs);
+    
+    logDebug(BridgeLog::Event::serialSysExChunk, receivedMs, data, size, isLast ? 1 : 0);
+}
+
+void MidiSerialBridge::handleSerialDebugText(const char* text, int length)
+{
+    if (onDisplayMessage)
+        onDisplayMessage(applyTimeStamp("Serial Says: " + juce::String::fromUTF8(text, length), serialMessageTime()));
+}
+
+void MidiSerialBridge::logDebug(BridgeLog::Event event, double timeMs, const juce::uint8* data, int size, juce::uint8 flags)
+{
+    if (debugLogging.load(std::memory_order_relaxed))
+        debugLog.push(event, timeMs, data, size, flags);
+}
+
+int MidiSerialBridge::drainDebugLog(int maxRecords)
+{
+    BridgeLog::Record record;
+    int numTaken = 0;
     
-    // Handle debug messages
-    if (data[0] == MSG_DEBUG && messageData.getSize() > 4)
+    while (numTaken < maxRecords && debugLog.pop(record))
     {
-        juce::String debugMsg = juce::String::fromUTF8(
-            reinterpret_cast<const char*>(data + 4),
-            data[3]);
+        ++numTaken;
         
-        if (onDisplayMessage)
-            onDisplayMessage(applyTimeStamp("Serial Says: " + debugMsg));
+        if (onDebugMessage)
+            onDebugMessage(applyTimeStamp(describeLogRecord(record), record.timeMs));
     }
-    else
+    
+    const juce::uint64 dropped = debugLog.getNumDropped();
+    
+    if (dropped != debugRecordsDroppedReported)
     {
-        // Regular MIDI message
         if (onDebugMessage)
-            onDebugMessage(applyTimeStamp("Serial In: " + describeMidiMessage(data, static_cast<int>(messageData.getSize()))));
-        
-        // Send to MIDI output
-        if (midiOutput != nullptr)
-        {
-            juce::MidiMessage msg(data, static_cast<int>(messageData.getSize()));
-            juce::MidiMessage transformed(msg);
-            if (processOutgoingMessage(msg, transformed))
-            {
-                midiOutput->sendMessageNow(transformed);
-                if (onMidiSent)
-                    onMidiSent();
-            }
-        }
+            onDebugMessage(applyTimeStamp(juce::String::formatted("Debug log full, %llu records dropped",
+                                                                  (unsigned long long) (dropped - debugRecordsDroppedReported))));
+        debugRecordsDroppedReported = dropped;
     }
     
-    messageData.reset();
-    dataExpected = 0;
+    return numTaken;
 }
 
-int MidiSerialBridge::getDataLength(int status)
+juce::String MidiSerialBridge::describeLogRecord(const BridgeLog::Record& record)
 {
-    juce::uint8 channel;
-    
-    switch (status & TAG_MASK)
+    switch (record.event)
     {
-        case TAG_PROGRAM:
-        case TAG_CHANNEL_PRESSURE:
-            return 1;
+        case BridgeLog::Event::midiInSysEx:
+            return juce::String::formatted("MIDI In: SysEx, %d bytes", record.length);
             
-        case TAG_NOTE_ON:
-        case TAG_NOTE_OFF:
-        case TAG_KEY_PRESSURE:
-        case TAG_CONTROLLER:
-        case TAG_PITCH_BEND:
-            return 2;
-            
-        case TAG_SPECIAL:
-            if (status == MSG_DEBUG)
-                return 3; // Debug messages: { 0xFF, 0, 0, <len>, Msg }
-            
-            if (status == MSG_SYSEX_START)
-                return 65535; // SysEx messages go until MSG_SYSEX_END
-            
-            channel = status & CHANNEL_MASK;
-            if (channel < 3)
-                return 2;
-            else if (channel < 6)
-                return 1;
-            return 0;
+        case BridgeLog::Event::serialSysExChunk:
+            return juce::String::formatted("Serial In: SysEx chunk, %d bytes%s",
+                                           record.length, (record.flags & 1) ? " (end)" : "");
             
         default:
-            return -2; // UNKNOWN_MIDI
+            break;
     }
+    
+    juce::String text = record.event == BridgeLog::Event::midiIn ? "MIDI In: " : "Serial In: ";
+    text << describeMidiMessage(record.bytes, record.numBytes);
+    
+    // Long SysEx only keeps its first bytes
+    if (record.length > record.numBytes)
+        text << juce::String::formatted("... (%d bytes)", record.length);
+    
+    return text;
 }
 
 juce::String MidiSerialBridge::describeMidiMessage(const juce::MidiMessage& message)
@@ -447,179 +1015,117 @@ juce::String MidiSerialBridge::describeMidiMessage(const juce::uint8* data, int
 
 juce::String MidiSerialBridge::applyTimeStamp(const juce::String& message)
 {
-    double seconds = (juce::Time::getCurrentTime() - attachTime).inSeconds();
-    return juce::String::formatted("+%.1f - ", seconds) + message;
+    return applyTimeStamp(message, juce::Time::getMillisecondCounterHiRes());
+}
+
+juce::String MidiSerialBridge::applyTimeStamp(const juce::String& message, double timeMs)
+{
+    // Monotonic: seconds since attach() to the tenth of a millisecond
+    const double seconds = (timeMs - attachTimeMs) * 0.001;
+    return juce::String::formatted("+%.4f - ", seconds) + message;
 }
 
 // ---------------------- Runtime configuration -------------------------------
+void MidiSerialBridge::publishConfig()
+{
+    settings.compile();
+    auto next = std::make_unique<BridgeConfig>(settings);
+    
+    // Publish the new snapshot, then wait for readers still using the old one
+    std::unique_ptr<const BridgeConfig> old(activeConfig.exchange(next.release()));
+    
+    while (configReaders.load() > 0)
+        juce::Thread::yield();
+}
+
 void MidiSerialBridge::setStringVelocityScale(int stringIndex, int scale)
 {
     if (stringIndex < 0 || stringIndex >= 6) return;
     scale = juce::jlimit(1, 10, scale);
-    stringVelocityScale[stringIndex] = scale;
+    if (settings.stringVelocityScale[stringIndex] == scale) return;
+    settings.stringVelocityScale[stringIndex] = scale;
+    publishConfig();
 }
 
 void MidiSerialBridge::setScale(int rootNote, const juce::Array<int>& intervals)
 {
-    rootNotePc = ((rootNote % 12) + 12) % 12;
-    for (int i = 0; i < 12; ++i) diatonicMask[i] = false;
+    bool mask[12] = {};
+    const int root = ((rootNote % 12) + 12) % 12;
     for (int interval : intervals)
     {
-        int pc = ((rootNotePc + interval) % 12 + 12) % 12;
-        diatonicMask[pc] = true;
+        int pc = ((root + interval) % 12 + 12) % 12;
+        mask[pc] = true;
     }
+
+    if (root == settings.rootNotePc && std::equal(mask, mask + 12, settings.diatonicMask)) return;
+    settings.rootNotePc = root;
+    std::copy(mask, mask + 12, settings.diatonicMask);
+    publishConfig();
 }
 
 void MidiSerialBridge::setStringOctaveShift(int stringIndex, int shift)
 {
     if (stringIndex < 0 || stringIndex >= 6) return;
     shift = juce::jlimit(-4, 4, shift);
-    octaveShift[stringIndex] = shift;
+    if (settings.octaveShift[stringIndex] == shift) return;
+    settings.octaveShift[stringIndex] = shift;
+    publishConfig();
 }
 
 void MidiSerialBridge::setStringSemitoneShift(int stringIndex, int shift)
 {
     if (stringIndex < 0 || stringIndex >= 6) return;
     shift = juce::jlimit(-12, 12, shift);
-    semitoneShift[stringIndex] = shift;
+    if (settings.semitoneShift[stringIndex] == shift) return;
+    settings.semitoneShift[stringIndex] = shift;
+    publishConfig();
 }
 
-juce::String MidiSerialBridge::getScaleDescription() const
+void MidiSerialBridge::setFilterEnabled(bool enabled)
 {
-    static const char* names[] = {"C","C#","D","D#","E","F","F#","G","G#","A","A#","B"};
-    juce::String allowed;
-    for (int i = 0; i < 12; ++i)
-        if (diatonicMask[i]) allowed << names[i] << " ";
-    return juce::String(names[rootNotePc]) + " scale: " + allowed.trim();
+    if (settings.filterEnabled == enabled) return;
+    settings.filterEnabled = enabled;
+    publishConfig();
 }
 
-// ---------------------- Processing helpers ---------------------------------
-bool MidiSerialBridge::shouldFilterOutNote(int midiNote) const
+void MidiSerialBridge::setDiatonicMode(DiatonicMode m)
 {
-    if (! filterEnabled) return false;
-    int pc = ((midiNote % 12) + 12) % 12;
-    return ! diatonicMask[pc];
+    if (settings.diatonicMode == m) return;
+    settings.diatonicMode = m;
+    publishConfig();
 }
 
-int MidiSerialBridge::applyVelocityScaling(int channel, int velocity) const
+juce::String MidiSerialBridge::getScaleDescription() const
 {
-    // Assume channels 0..5 map to guitar strings lowE..highE or vice versa.
-    // We cannot know pickup ordering; user can adjust scales accordingly.
-    if (channel >= 0 && channel < 6)
-    {
-        float factor = stringVelocityScale[channel] / 10.0f; // 1..10 -> 0.1..1.0
-        int scaled = (int)std::round(velocity * factor);
-        return juce::jlimit(1, 127, scaled); // avoid zero (interpreted as NoteOff)
-    }
-    return velocity;
+    return settings.getScaleDescription();
 }
 
 // New setters for global octave and unified channel
 void MidiSerialBridge::setGlobalOctaveShift(int shift)
 {
-    globalOctaveShift = juce::jlimit(-4, 4, shift);
+    shift = juce::jlimit(-4, 4, shift);
+    if (settings.globalOctaveShift == shift) return;
+    settings.globalOctaveShift = shift;
+    publishConfig();
 }
 
 void MidiSerialBridge::setUnifiedChannel(int channel)
 {
-    unifiedChannel = juce::jlimit(1, 16, channel);
+    channel = juce::jlimit(1, 16, channel);
+    if (settings.unifiedChannel == channel) return;
+    settings.unifiedChannel = channel;
+    publishConfig();
 }
 
-bool MidiSerialBridge::processOutgoingMessage(const juce::MidiMessage& original, juce::MidiMessage& transformed)
+// ---------------------- Processing helpers ---------------------------------
+bool MidiSerialBridge::processOutgoingMessage(NoteStateTracker& noteStates, const juce::MidiMessage& original,
+                                              juce::MidiMessage& transformed)
 {
-    int originalChannel0 = original.getChannel() - 1;
-    int stringIndex = (originalChannel0 >= 0 && originalChannel0 < 6) ? originalChannel0 : -1;
-    int outChannel0 = unifiedChannel - 1;
-
-    if (original.isNoteOn())
-    {
-        int note = original.getNoteNumber();
-        if (stringIndex >= 0)
-            note += (globalOctaveShift * 12) + (octaveShift[stringIndex] * 12) + semitoneShift[stringIndex];
-        else
-            note += (globalOctaveShift * 12);
-        note = juce::jlimit(0, 127, note);
-
-        if (shouldFilterOutNote(note))
-        {
-            if (diatonicMode == DiatonicMode::ReplaceUp)
-            {
-                // Replace with next higher diatonic pitch class within MIDI range
-                int nn = note;
-                for (int step = 1; step <= 12; ++step)
-                {
-                    int candidate = note + step;
-                    if (candidate > 127) break;
-                    int pc = ((candidate % 12) + 12) % 12;
-                    if (diatonicMask[pc]) { nn = candidate; break; }
-                }
-                if (nn != note)
-                {
-                    replacedNotes[(originalChannel0 << 8) | note] = nn;
-                    note = nn;
-                }
-                else
-                {
-                    // fallback: drop if no replacement found
-                    suppressedNotes.insert((originalChannel0 << 8) | note);
-                    return false;
-                }
-            }
-            else
-            {
-                // Mark suppressed so matching NoteOff also filtered
-                suppressedNotes.insert((originalChannel0 << 8) | note);
-                return false;
-            }
-        }
-        int vel = applyVelocityScaling(stringIndex >= 0 ? stringIndex : originalChannel0, (int) original.getVelocity());
-        transformed = juce::MidiMessage::noteOn(outChannel0 + 1, note, (juce::uint8) vel);
-        transformed.setTimeStamp(original.getTimeStamp());
-        return true;
-    }
-    else if (original.isNoteOff())
-    {
-        int note = original.getNoteNumber();
-        if (stringIndex >= 0)
-        {
-            int shifted = note + (globalOctaveShift * 12) + (octaveShift[stringIndex] * 12) + semitoneShift[stringIndex];
-            shifted = juce::jlimit(0, 127, shifted);
-            auto keyOrig = (originalChannel0 << 8) | note;
-            auto it = replacedNotes.find(keyOrig);
-            if (it != replacedNotes.end())
-            {
-                note = it->second;
-                replacedNotes.erase(it);
-            }
-            else
-            {
-                note = shifted;
-            }
-        }
-        else
-        {
-            note += (globalOctaveShift * 12);
-            note = juce::jlimit(0, 127, note);
-        }
-        int key = (originalChannel0 << 8) | note;
-        if (suppressedNotes.find(key) != suppressedNotes.end())
-        {
-            // Drop matching note-off
-            suppressedNotes.erase(key);
-            return false;
-        }
-        transformed = juce::MidiMessage::noteOff(outChannel0 + 1, note);
-        transformed.setTimeStamp(original.getTimeStamp());
-        return true;
-    }
-    else
-    {
-        // Non-note messages pass through unchanged
-        transformed = original;
-        if (original.isProgramChange() || original.isController() || original.isAftertouch() || original.isPitchWheel())
-            transformed.setChannel(outChannel0 + 1);
-        return true;
-    }
+    // One snapshot per message: a settings change lands between messages
+    ++configReaders;
+    const bool result = activeConfig.load()->transform(noteStates, original, transformed);
+    --configReaders;
+    return result;
 }
 
 // Per-string channel mapping removed; unified channel is used for all events
@@ -3,14 +3,19 @@
 #include <juce_audio_devices/juce_audio_devices.h>
 #include <juce_events/juce_events.h>
 #include "SerialPortManager.h"
-#include <unordered_set>
+#include "SerialPortRegistry.h"
+#include "MidiStreamParser.h"
+#include "MidiOutputScheduler.h"
+#include "NoteStateTracker.h"
+#include "BridgeConfig.h"
+#include "BridgeLog.h"
+#include "TrafficCapture.h"
 
 /**
  * MidiSerialBridge manages the bidirectional bridge between MIDI and Serial ports
  * This is the JUCE equivalent of the Qt Bridge class
  */
-class MidiSerialBridge : public juce::Timer,
-                         private juce::MidiInputCallback
+class MidiSerialBridge : private juce::MidiInputCallback
 {
 public:
     MidiSerialBridge();
@@ -24,10 +29,119 @@ public:
     // Detach from all ports
     void detach();
     
+    // Replace a single endpoint while the others keep running. An empty name
+    // closes that endpoint; the current name is a no-op (so an unrelated
+    // change doesn't reset the Arduino). MIDI ports are swapped with a
+    // minimal gap: the new one is opened before the old one is closed (a
+    // new input only starts once the old one has stopped).
+    bool setSerialPort(const juce::String& serialPortName, bool forceReopen = false);
+    bool setMidiInput(const juce::String& midiInputName);
+    bool setMidiOutput(const juce::String& midiOutputName);
+    
     // Check if currently bridging
     bool isActive() const { return serialPort.isOpen() || midiInput != nullptr || midiOutput != nullptr; }
+    bool isSerialOpen() const { return serialPort.isOpen(); }
+    
+    // MIDI -> serial transmit queue counters
+    SerialPortManager::TxStats getSerialTxStats() const { return serialPort.getTxStats(); }
+    
+    // Serial -> MIDI receive ring counters (includes the high-water mark)
+    SerialPortManager::RxStats getSerialRxStats() const { return serialPort.getRxStats(); }
+    
+    // Serial baud rate used by attach() (any positive rate, default 115200).
+    // Takes effect the next time the serial port is opened.
+    void setSerialBaudRate(int baudRate) { serialBaudRate = juce::jmax(1, baudRate); }
+    int  getSerialBaudRate() const { return serialBaudRate; }
+    
+    // Rate the driver actually applied, or 0 if the port isn't open
+    int  getEffectiveSerialBaudRate() const { return serialPort.getBaudRate(); }
+    
+    // Low-latency tty mode (VMIN/VTIME, ASYNC_LOW_LATENCY, FTDI latency timer),
+    // applied the next time the serial port is opened
+    void setSerialLowLatency(bool enabled) { serialPort.setLowLatencyMode(enabled); }
+    bool getSerialLowLatency() const { return serialPort.getLowLatencyMode(); }
+    SerialPortManager::LowLatencyStatus getSerialLowLatencyStatus() const { return serialPort.getLowLatencyStatus(); }
+    
+    // Slave path of the pty loopback (empty unless the serial port is "pty:")
+    juce::String getSerialLoopbackPath() const { return serialPort.getPseudoTerminalPath(); }
+    
+    // Reopen the serial port automatically (with backoff) after I/O errors,
+    // e.g. an Arduino reset or a USB glitch. MIDI ports stay open meanwhile.
+    void setAutoReconnect(bool enabled) { autoReconnect = enabled; }
+    bool getAutoReconnect() const { return autoReconnect; }
+    
+    // Serial receive ring capacity, applied the next time the port is opened
+    void setSerialRxBufferSize(int numBytes) { serialPort.setRxBufferSize(numBytes); }
+    
+    // Serial -> MIDI parser counters (messages and stream errors)
+    MidiStreamParser::Stats getSerialParserStats() const { return serialParser.getStats(); }
+    
+    // Serial -> MIDI latency: from the estimated arrival of a message's last
+    // byte to its hand-off to the MIDI output. Reset when a session opens.
+    struct LatencyStats
+    {
+        juce::uint64 messages = 0;
+        double averageMs = 0.0;
+        double maxMs = 0.0;
+    };
+    
+    LatencyStats getSerialLatencyStats() const;
+    
+    // Fixed-latency mode: hold each serial -> MIDI message until it arrived
+    // delayMs ago, then release it from a high-priority thread, trading a
+    // constant offset for the read/parse jitter. 0 sends as soon as parsed.
+    // Takes effect the next time the serial port is opened.
+    void setOutputDelay(double delayMs) { outputDelayMs = juce::jmax(0.0, delayMs); }
+    double getOutputDelay() const { return outputDelayMs; }
+    
+    MidiOutputScheduler::Stats getOutputSchedulerStats() const { return outputScheduler.getStats(); }
+    
+    // Real-time scheduling, CPU pinning and memory locking for the serial
+    // reader, writer, dispatch and output scheduler threads. Takes effect
+    // the next time the serial port is opened; each thread logs what it got.
+    void setRealtimeOptions(const RealtimeOptions& options);
+    const RealtimeOptions& getRealtimeOptions() const { return realtimeOptions; }
+    
+    // What each I/O thread of the current session is running with
+    juce::Array<RealtimeThreading::Report> getThreadSchedulingReports() const;
+    
+    // Forward SysEx in fixed-size chunks as it arrives, in both directions,
+    // instead of buffering whole messages (no size limit). Serial -> MIDI
+    // takes effect the next time the serial port is opened.
+    void setSysExStreaming(bool enabled) { sysExStreaming = enabled; }
+    bool getSysExStreaming() const { return sysExStreaming; }
+    
+    // Whether serial -> MIDI can stream too. Not on Linux: JUCE's ALSA
+    // output encodes each MidiMessage on its own and discards chunks that
+    // don't start with a status byte, so serial SysEx is kept whole there.
+   #if JUCE_LINUX
+    static constexpr bool canStreamSysExToMidi = false;
+   #else
+    static constexpr bool canStreamSysExToMidi = true;
+   #endif
+    
+    static constexpr int sysExChunkSize = 256;
+    
+    // Record every message passing through the bridge. The I/O threads
+    // only queue binary records; the text is made by drainDebugLog().
+    void setDebugLogging(bool enabled) { debugLogging = enabled; }
+    bool getDebugLogging() const { return debugLogging; }
+    
+    // Format up to maxRecords queued debug records and pass them to
+    // onDebugMessage on the calling thread (call from one thread only,
+    // e.g. a UI timer). Returns how many were taken.
+    int drainDebugLog(int maxRecords = 256);
+    
+    // Record all bridged traffic (serial reads and writes, MIDI in and out)
+    // to a binary capture file, across reconnects, until stopCapture()
+    bool startCapture(const juce::File& file, juce::String& errorMessage);
+    void stopCapture();
+    bool isCapturing() const { return capture.isRunning(); }
+    TrafficCapture::Stats getCaptureStats() const { return capture.getStats(); }
     
-    // Callback types for status updates
+    // Callback types for status updates.
+    // Serial-side events are reported from the serial reader thread;
+    // onDebugMessage is called from drainDebugLog().
     std::function<void(const juce::String&)> onDisplayMessage;
     std::function<void(const juce::String&)> onDebugMessage;
     std::function<void()> onMidiReceived;
@@ -35,53 +149,101 @@ public:
     std::function<void()> onSerialTraffic;
 
     // Runtime configuration -------------------------------------------------
+    // Call the setters from one thread (the message thread). Each change is
+    // published as a new BridgeConfig snapshot that the MIDI and serial
+    // threads pick up at their next message, without locks.
+    //
     // Set per-string velocity scale (index 0..5). Value expected 1..10.
     void setStringVelocityScale(int stringIndex, int scale);
     // Set root note (0=C .. 11=B) and scale type intervals (e.g. major)
     void setScale(int rootNote, const juce::Array<int>& intervals); // intervals are pitch-class offsets from root
     // Enable / disable diatonic filtering
-    void setFilterEnabled(bool enabled) { filterEnabled = enabled; }
-    bool getFilterEnabled() const { return filterEnabled; }
+    void setFilterEnabled(bool enabled);
+    bool getFilterEnabled() const { return settings.filterEnabled; }
 
-    enum class DiatonicMode { Off = 0, Filter = 1, ReplaceUp = 2 };
-    void setDiatonicMode(DiatonicMode m) { diatonicMode = m; }
-    DiatonicMode getDiatonicMode() const { return diatonicMode; }
+    using DiatonicMode = BridgeConfig::DiatonicMode;
+    void setDiatonicMode(DiatonicMode m);
+    DiatonicMode getDiatonicMode() const { return settings.diatonicMode; }
 
     // Per-string tuning setters
     void setStringOctaveShift(int stringIndex, int shift);
     void setStringSemitoneShift(int stringIndex, int shift);
     // Global octave shift applied to all strings (-4..+4)
     void setGlobalOctaveShift(int shift);
-    int  getGlobalOctaveShift() const { return globalOctaveShift; }
+    int  getGlobalOctaveShift() const { return settings.globalOctaveShift; }
 
     // Set unified output channel (1..16) for all strings
     void setUnifiedChannel(int channel);
-    int  getUnifiedChannel() const { return unifiedChannel; }
+    int  getUnifiedChannel() const { return settings.unifiedChannel; }
 
     // Utility to describe current scale
     juce::String getScaleDescription() const;
     
+    // Everything above, as last published (e.g. to replay a capture with)
+    const BridgeConfig& getSettings() const { return settings; }
+    
 private:
-    // Timer callback to poll serial data
-    void timerCallback() override;
+    class SerialDispatchThread;
+    class SerialSupervisorThread;
+    
+    // Open the transport for a session. May block (network ports), so it
+    // is called without serialSessionLock; reports failures itself.
+    std::unique_ptr<SerialTransport> connectSerialPort(const juce::String& serialPortName);
+    
+    // Serial session management (call with serialSessionLock held)
+    bool openSerialSession(std::unique_ptr<SerialTransport> transport, const juce::String& serialPortName);
+    void closeSerialSession();
+    void resetParserState();
+    
+    // Reconnect support: remember which device we were talking to, then
+    // look it up again by stable id, USB identity or path
+    void rememberSerialIdentity(const juce::String& serialPortName);
+    juce::String findSerialPortForReconnect();
+    bool recoverSerialSession(juce::Thread& supervisor);
+    void startSerialSupervisor();
+    void stopSerialSupervisor();
     
     // MIDI input callback
     void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
+    void handlePartialSysexMessage(juce::MidiInput* source, const juce::uint8* messageData,
+                                   int numBytesSoFar, double timestamp) override;
+    
+    // Send through the current MIDI output, if any (safe from any thread)
+    bool sendToMidiOutput(const juce::MidiMessage& message);
+    
+    // Note Off for every note the bridge left sounding in one direction.
+    // MIDI input notes went to the serial port and the MIDI output: call
+    // with the MIDI input stopped, before the serial port closes. Serial
+    // notes went to the MIDI output: call with the dispatch thread stopped.
+    void releaseMidiInputNotes();
+    void releaseSerialNotes();
     
-    // Process serial data
+    // Parse everything waiting in the serial receive ring
+    // (called from the dispatch thread)
     void processSerialData();
-    void onDataByte(juce::uint8 byte);
-    void onStatusByte(juce::uint8 byte);
-    void sendMidiMessage();
+    
+    // serialParser callbacks
+    void handleSerialMessage(const juce::uint8* data, int size);
+    void handleSerialDebugText(const char* text, int length);
+    void handleSerialRealtime(juce::uint8 byte);
+    void handleSerialSysExChunk(const juce::uint8* data, int size, bool isLast);
+    
+    // Clock (24 per beat) and active sensing (every 300 ms) would flood the debug log
+    static bool isHighRateRealtime(juce::uint8 byte) { return byte == 0xF8 || byte == 0xFE; }
 
     // Message transform helpers
-    bool shouldFilterOutNote(int midiNote) const; // returns true if note should be suppressed
-    bool processOutgoingMessage(const juce::MidiMessage& original, juce::MidiMessage& transformed); // returns false if filtered
+    bool processOutgoingMessage(NoteStateTracker& noteStates, const juce::MidiMessage& original,
+                                juce::MidiMessage& transformed); // returns false if filtered
+    
+    // Queue a debug record if debug logging is on (any thread)
+    void logDebug(BridgeLog::Event event, double timeMs, const juce::uint8* data, int size, juce::uint8 flags = 0);
+    juce::String describeLogRecord(const BridgeLog::Record& record);
     
     // Utility functions
     juce::String describeMidiMessage(const juce::MidiMessage& message);
     juce::String describeMidiMessage(const juce::uint8* data, int length);
     juce::String applyTimeStamp(const juce::String& message);
+    juce::String applyTimeStamp(const juce::String& message, double timeMs);
     
     // MIDI message parsing constants
     static constexpr juce::uint8 STATUS_MASK = 0x80;
@@ -99,44 +261,75 @@ private:
     
     static constexpr juce::uint8 MSG_SYSEX_START = 0xF0;
     static constexpr juce::uint8 MSG_SYSEX_END = 0xF7;
-    static constexpr juce::uint8 MSG_DEBUG = 0xFF;
-    
-    static bool isVoiceMessage(juce::uint8 tag) { return tag >= 0x80 && tag <= 0xEF; }
-    static bool isSysCommonMessage(juce::uint8 tag) { return tag >= 0xF0 && tag <= 0xF7; }
-    static bool isRealtimeMessage(juce::uint8 tag) { return tag >= 0xF8 && tag < 0xFF; }
-    
-    static int getDataLength(int status);
     
     // Member variables
+    TrafficCapture capture;     // before serialPort: its threads write to it
     SerialPortManager serialPort;
+    std::unique_ptr<SerialDispatchThread> serialDispatchThread;
+    std::unique_ptr<SerialSupervisorThread> serialSupervisorThread;
+    juce::CriticalSection serialSessionLock;
+    SerialPortManager::PortInfo serialIdentity;
+    bool autoReconnect { true };
     std::unique_ptr<juce::MidiInput> midiInput;
     std::unique_ptr<juce::MidiOutput> midiOutput;
+    std::atomic<juce::MidiOutput*> activeMidiOutput { nullptr }; // what senders use
+    std::atomic<int> midiOutputUsers { 0 };                      // senders inside sendToMidiOutput
     
     juce::String midiInputName;
     juce::String midiOutputName;
+    int serialBaudRate { 115200 };
     
-    // MIDI parsing state
-    int runningStatus;
-    int dataExpected;
-    juce::MemoryBlock messageData;
+    // Serial -> MIDI parsing state (dispatch thread only)
+    MidiStreamParser serialParser;
     
-    juce::Time attachTime;
+    // Arrival time (ms, getMillisecondCounterHiRes) of the message the
+    // parser is delivering
+    double serialMessageTime();
+    void recordSerialLatency(double receivedMs);
+    
+    // Send a parsed serial message now (outputScheduler's release callback)
+    void releaseSerialMessage(const juce::uint8* data, int size, double receivedMs);
+    
+    MidiOutputScheduler outputScheduler;
+    double outputDelayMs { 0.0 };
+    
+    // I/O thread scheduling (reports arrive on the threads themselves)
+    void applyRealtimeOptions(const juce::String& threadName);
+    void reportThreadScheduling(const RealtimeThreading::Report& report);
+    
+    RealtimeOptions realtimeOptions;
+    bool memoryLocked { false };
+    juce::CriticalSection threadReportLock;
+    juce::Array<RealtimeThreading::Report> threadReports;
+    
+    std::atomic<juce::uint64> serialLatencyMessages { 0 };    // dispatch thread writes
+    std::atomic<juce::uint64> serialLatencyTotalUs { 0 };
+    std::atomic<juce::uint64> serialLatencyMaxUs { 0 };
+    
+    std::atomic<bool> sysExStreaming { false };
+    int midiSysExBytesQueued { 0 };     // MIDI -> serial, MIDI callback thread only
+    int midiSysExBytesCaptured { 0 };   // same, for the traffic capture
+    
+    double attachTimeMs;    // monotonic, getMillisecondCounterHiRes
+    
+    std::atomic<bool> debugLogging { false };
+    BridgeLog debugLog;
+    juce::uint64 debugRecordsDroppedReported { 0 };    // drainDebugLog only
 
     // Runtime settings -------------------------------------------------------
-    int stringVelocityScale[6]; // 1..10 values, mapped to velocity multiplier
-    int octaveShift[6]; // -4..+4 per string
-    int semitoneShift[6]; // -12..12 per string
-    int unifiedChannel; // 1..16 single channel output
-    int globalOctaveShift; // -4..+4 applied to all strings
-    int rootNotePc; // 0..11
-    bool diatonicMask[12]; // allowed pitch classes
-    bool filterEnabled { false };
-    DiatonicMode diatonicMode { DiatonicMode::Filter };
-    std::unordered_set<int> suppressedNotes; // store (channel<<8)|note for which NoteOn was filtered, so we also drop NoteOff
-    std::unordered_map<int,int> replacedNotes; // original key -> replaced note
-
-    // Internal helper
-    int applyVelocityScaling(int stringIndex, int velocity) const;
+    // settings is the setters' working copy (message thread only).
+    // publishConfig() compiles it and swaps a copy in; the old
+    // snapshot is freed once no reader is inside processOutgoingMessage.
+    void publishConfig();
+    
+    BridgeConfig settings;
+    std::atomic<const BridgeConfig*> activeConfig { nullptr }; // what the transform reads
+    std::atomic<int> configReaders { 0 };                      // threads inside processOutgoingMessage
+    
+    // What each NoteOn became, so its NoteOff matches. One per direction,
+    // each only touched by that direction's thread (or with it stopped).
+    NoteStateTracker midiNoteStates;    // MIDI input -> serial, MIDI callback thread
+    NoteStateTracker serialNoteStates;  // serial -> MIDI output, dispatch thread
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiSerialBridge)
 };
@@ -0,0 +1,517 @@
+#include "MidiStreamParser.h"
+
+#if JUCE_INTEL && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define HAIRLESS_SCAN_SSE2 1
+    #include <immintrin.h>
+    
+    // AVX2 is picked at runtime, so the build doesn't need -mavx2
+    #if JUCE_MSVC
+        #define HAIRLESS_SCAN_AVX2 1
+        #define HAIRLESS_TARGET_AVX2
+    #elif defined(__GNUC__) || defined(__clang__)
+        #define HAIRLESS_SCAN_AVX2 1
+        #define HAIRLESS_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#elif JUCE_ARM && (defined(__ARM_NEON) || defined(__ARM_NEON__)) && (defined(__aarch64__) || defined(_M_ARM64))
+    #define HAIRLESS_SCAN_NEON 1
+    #include <arm_neon.h>
+#endif
+
+// { 0xFF, 0, 0, <len>, up to 255 bytes of text }
+static constexpr int maxDebugMessageSize = 4 + 255;
+
+// SysEx has no declared length: it runs until MSG_SYSEX_END
+static constexpr int sysExDataLength = 0x7FFFFFFF;
+
+// Streamed SysEx keeps this many bytes back until the next chunk, so the
+// final chunk always carries some data along with the 0xF7
+static constexpr int sysExHoldBack = 3;
+
+//==============================================================================
+// Status byte scanners: every MIDI status byte has the top bit set and every
+// data byte has it clear, so the top bits of a vector are exactly the mask
+// of status positions
+static int findStatusByteScalar(const juce::uint8* data, int numBytes)
+{
+    for (int i = 0; i < numBytes; ++i)
+        if (data[i] & 0x80)
+            return i;
+    
+    return numBytes;
+}
+
+#if HAIRLESS_SCAN_SSE2 || HAIRLESS_SCAN_AVX2
+static inline int lowestSetBit(juce::uint32 mask)
+{
+   #if JUCE_MSVC
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+   #else
+    return __builtin_ctz(mask);
+   #endif
+}
+#endif
+
+#if HAIRLESS_SCAN_SSE2
+static int findStatusByteSSE2(const juce::uint8* data, int numBytes)
+{
+    int i = 0;
+    
+    for (; i + 16 <= numBytes; i += 16)
+    {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const auto mask = static_cast<juce::uint32>(_mm_movemask_epi8(block));
+        
+        if (mask != 0)
+            return i + lowestSetBit(mask);
+    }
+    
+    return i + findStatusByteScalar(data + i, numBytes - i);
+}
+#endif
+
+#if HAIRLESS_SCAN_AVX2
+HAIRLESS_TARGET_AVX2 static int findStatusByteAVX2(const juce::uint8* data, int numBytes)
+{
+    int i = 0;
+    
+    for (; i + 32 <= numBytes; i += 32)
+    {
+        const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const auto mask = static_cast<juce::uint32>(_mm256_movemask_epi8(block));
+        
+        if (mask != 0)
+            return i + lowestSetBit(mask);
+    }
+    
+    return i + findStatusByteSSE2(data + i, numBytes - i);
+}
+#endif
+
+#if HAIRLESS_SCAN_NEON
+// NEON has no movemask: test 16 bytes at once, then find the byte
+static int findStatusByteNEON(const juce::uint8* data, int numBytes)
+{
+    int i = 0;
+    
+    for (; i + 16 <= numBytes; i += 16)
+        if (vmaxvq_u8(vld1q_u8(data + i)) & 0x80)
+            break;
+    
+    return i + findStatusByteScalar(data + i, numBytes - i);
+}
+#endif
+
+//==============================================================================
+MidiStreamParser::MidiStreamParser()
+{
+    findStatusByte = findStatusByteScalar;
+    
+   #if HAIRLESS_SCAN_SSE2
+    findStatusByte = findStatusByteSSE2;
+    scannerName = "SSE2";
+   #endif
+    
+   #if HAIRLESS_SCAN_AVX2
+    if (juce::SystemStats::hasAVX2())
+    {
+        findStatusByte = findStatusByteAVX2;
+        scannerName = "AVX2";
+    }
+   #endif
+    
+   #if HAIRLESS_SCAN_NEON
+    findStatusByte = findStatusByteNEON;
+    scannerName = "NEON";
+   #endif
+    
+    setMaxSysExSize(65536);
+}
+
+void MidiStreamParser::setMaxSysExSize(int numBytes)
+{
+    maxSysExSize = juce::jmax(3, numBytes);
+    longCapacity = juce::jmax(maxSysExSize, sysExChunkSize, maxDebugMessageSize);
+    longMessage.malloc(static_cast<size_t>(longCapacity));
+    reset();
+}
+
+void MidiStreamParser::setSysExStreaming(bool enabled, int chunkSize)
+{
+    sysExStreaming = enabled;
+    sysExChunkSize = juce::jmax(2 * (sysExHoldBack + 1), chunkSize);
+    setMaxSysExSize(maxSysExSize);
+}
+
+void MidiStreamParser::reset()
+{
+    pending = Pending::none;
+    shortSize = 0;
+    longSize = 0;
+    longOverflowed = false;
+    sysExChunkSent = false;
+    dataExpected = 0;
+    runningStatus = 0;
+    streamPosition = 0;
+    messagePosition = 0;
+}
+
+void MidiStreamParser::parse(const juce::uint8* data, int numBytes)
+{
+    if (numBytes <= 0)
+        return;
+    
+    const juce::uint64 basePosition = streamPosition;
+    streamPosition += static_cast<juce::uint64>(numBytes);
+    
+    int i = 0;
+    
+    while (i < numBytes)
+    {
+        const juce::uint8 nextByte = data[i];
+        messagePosition = basePosition + static_cast<juce::uint64>(i);
+        
+        if (isRealtimeByte(nextByte))
+        {
+            // Fast path: out immediately, parser state untouched
+            bump(realtimeMessages);
+            
+            if (onRealtimeMessage)
+                onRealtimeMessage(nextByte);
+            
+            ++i;
+            continue;
+        }
+        
+        if (nextByte & 0x80)
+        {
+            handleStatusByte(nextByte);
+            ++i;
+        }
+        else if (pending == Pending::shortMessage || pending == Pending::debug)
+        {
+            // At most a couple of bytes to go: not worth a scan
+            handleDataByte(nextByte);
+            ++i;
+        }
+        else
+        {
+            // SysEx payload or a running-status stream: everything up to
+            // the next status byte is data
+            const int runEnd = i + findStatusByte(data + i, numBytes - i);
+            consumeDataRun(data + i, runEnd - i, messagePosition);
+            i = runEnd;
+            continue;
+        }
+        
+        if (dataExpected == 0)
+            emit();
+    }
+    
+    // Don't sit on streamed SysEx until the next read
+    if (sysExStreaming && pending == Pending::sysEx)
+    {
+        messagePosition = streamPosition - 1;
+        flushSysExChunk(false);
+    }
+}
+
+// Same result as handleDataByte() on each byte in turn, but a run at a time
+void MidiStreamParser::consumeDataRun(const juce::uint8* data, int numBytes, juce::uint64 position)
+{
+    while (numBytes > 0)
+    {
+        if (pending == Pending::sysEx)
+        {
+            // SysEx only ends at a status byte, so the whole run belongs to it
+            appendLongRun(data, numBytes, position);
+            return;
+        }
+        
+        if (dataExpected == 0)
+        {
+            if (runningStatus == 0)
+            {
+                bump(unexpectedDataBytes, numBytes);
+                return;
+            }
+            
+            handleStatusByte(runningStatus);
+        }
+        
+        if (pending == Pending::shortMessage)
+        {
+            const int count = juce::jmin(dataExpected, numBytes);
+            
+            for (int i = 0; i < count; ++i)
+                shortMessage[shortSize++] = data[i];
+            
+            messagePosition = position + static_cast<juce::uint64>(count - 1);
+            position += static_cast<juce::uint64>(count);
+            data += count;
+            numBytes -= count;
+            dataExpected -= count;
+        }
+        else
+        {
+            // Debug messages: the length byte changes what is expected
+            messagePosition = position++;
+            handleDataByte(*data++);
+            --numBytes;
+        }
+        
+        if (dataExpected == 0)
+            emit();
+    }
+}
+
+void MidiStreamParser::handleStatusByte(juce::uint8 byte)
+{
+    if (byte == MSG_SYSEX_END && pending == Pending::sysEx)
+    {
+        appendLong(byte);
+        emit();
+        return;
+    }
+    
+    // Interrupted: deliver what we have, as the original bridge did
+    if (dataExpected > 0)
+    {
+        bump(incompleteMessages);
+        emit();
+    }
+    
+    // Voice messages set the running status, system common clears it
+    if (byte >= 0x80 && byte <= 0xEF)
+        runningStatus = byte;
+    else if (byte <= MSG_SYSEX_END)
+        runningStatus = 0;
+    
+    dataExpected = getDataLength(byte);
+    
+    if (dataExpected < 0)
+    {
+        bump(unknownStatusBytes);
+        dataExpected = 0;
+    }
+    
+    if (byte == MSG_SYSEX_START || byte == MSG_DEBUG)
+    {
+        pending = byte == MSG_SYSEX_START ? Pending::sysEx : Pending::debug;
+        longSize = 0;
+        longOverflowed = false;
+        appendLong(byte);
+    }
+    else
+    {
+        pending = Pending::shortMessage;
+        shortMessage[0] = byte;
+        shortSize = 1;
+    }
+}
+
+void MidiStreamParser::handleDataByte(juce::uint8 byte)
+{
+    if (dataExpected == 0 && runningStatus != 0)
+        handleStatusByte(runningStatus);
+    
+    if (dataExpected == 0)
+    {
+        bump(unexpectedDataBytes);
+        return;
+    }
+    
+    if (pending == Pending::shortMessage)
+    {
+        // getDataLength() never asks for more than two data bytes here
+        shortMessage[shortSize++] = byte;
+    }
+    else
+    {
+        appendLong(byte);
+    }
+    
+    --dataExpected;
+    
+    // The fourth byte of a debug message is the length of the text
+    if (pending == Pending::debug && dataExpected == 0 && longSize == 4)
+        dataExpected = longMessage[3];
+}
+
+void MidiStreamParser::appendLong(juce::uint8 byte)
+{
+    if (sysExStreaming && pending == Pending::sysEx && longSize >= sysExChunkSize)
+        flushSysExChunk(false);
+    
+    if (longSize < longCapacity)
+        longMessage[longSize++] = byte;
+    else
+        longOverflowed = true;
+}
+
+void MidiStreamParser::appendLongRun(const juce::uint8* data, int numBytes, juce::uint64 position)
+{
+    if (sysExStreaming && pending == Pending::sysEx)
+    {
+        while (numBytes > 0)
+        {
+            if (longSize >= sysExChunkSize)
+            {
+                messagePosition = position - 1;
+                flushSysExChunk(false);
+            }
+            
+            const int count = juce::jmin(numBytes, sysExChunkSize - longSize);
+            memcpy(longMessage + longSize, data, static_cast<size_t>(count));
+            longSize += count;
+            position += static_cast<juce::uint64>(count);
+            data += count;
+            numBytes -= count;
+        }
+        
+        return;
+    }
+    
+    const int count = juce::jmin(numBytes, longCapacity - longSize);
+    
+    memcpy(longMessage + longSize, data, static_cast<size_t>(count));
+    longSize += count;
+    
+    if (count < numBytes)
+        longOverflowed = true;
+}
+
+void MidiStreamParser::flushSysExChunk(bool isLast)
+{
+    if (isLast)
+    {
+        if (longSize > 0 && onSysExChunk)
+            onSysExChunk(longMessage, longSize, true);
+        
+        longSize = 0;
+        sysExChunkSent = false;
+        return;
+    }
+    
+    // Continuation chunks start with a data byte; keep them 4 bytes or more
+    // (JUCE's MidiMessage checks short messages against their status byte)
+    const int count = longSize - sysExHoldBack;
+    
+    if (count <= 0 || (count < 4 && sysExChunkSent))
+        return;
+    
+    if (onSysExChunk)
+        onSysExChunk(longMessage, count, false);
+    
+    memmove(longMessage, longMessage + count, static_cast<size_t>(longSize - count));
+    longSize -= count;
+    sysExChunkSent = true;
+}
+
+void MidiStreamParser::emit()
+{
+    switch (pending)
+    {
+        case Pending::none:
+            break;
+        
+        case Pending::shortMessage:
+            bump(messages);
+            if (onMessage)
+                onMessage(shortMessage, shortSize);
+            break;
+        
+        case Pending::sysEx:
+            if (sysExStreaming)
+            {
+                bump(sysExMessages);
+                flushSysExChunk(true);
+            }
+            else if (longOverflowed || longSize > maxSysExSize)
+            {
+                bump(sysExOverflows);
+            }
+            else
+            {
+                bump(sysExMessages);
+                if (onMessage)
+                    onMessage(longMessage, longSize);
+            }
+            break;
+        
+        case Pending::debug:
+            bump(debugMessages);
+            if (longSize > 4 && onDebugText)
+                onDebugText(reinterpret_cast<const char*>(longMessage + 4), longSize - 4);
+            break;
+    }
+    
+    pending = Pending::none;
+    shortSize = 0;
+    longSize = 0;
+    longOverflowed = false;
+    dataExpected = 0;
+}
+
+int MidiStreamParser::getDataLength(int status)
+{
+    switch (status & 0xF0)
+    {
+        case 0xC0: // program change
+        case 0xD0: // channel pressure
+            return 1;
+        
+        case 0x80: // note off
+        case 0x90: // note on
+        case 0xA0: // key pressure
+        case 0xB0: // controller
+        case 0xE0: // pitch bend
+            return 2;
+        
+        case 0xF0:
+        {
+            if (status == MSG_DEBUG)
+                return 3; // Debug messages: { 0xFF, 0, 0, <len>, Msg }
+            
+            if (status == MSG_SYSEX_START)
+                return sysExDataLength;
+            
+            const int index = status & 0x0F;
+            if (index < 3)
+                return 2;
+            else if (index < 6)
+                return 1;
+            return 0;
+        }
+        
+        default:
+            return -2; // not a status byte
+    }
+}
+
+MidiStreamParser::Stats MidiStreamParser::getStats() const
+{
+    Stats stats;
+    stats.messages = messages.load();
+    stats.sysExMessages = sysExMessages.load();
+    stats.realtimeMessages = realtimeMessages.load();
+    stats.debugMessages = debugMessages.load();
+    stats.incompleteMessages = incompleteMessages.load();
+    stats.unexpectedDataBytes = unexpectedDataBytes.load();
+    stats.unknownStatusBytes = unknownStatusBytes.load();
+    stats.sysExOverflows = sysExOverflows.load();
+    return stats;
+}
+
+void MidiStreamParser::resetStats()
+{
+    messages = 0;
+    sysExMessages = 0;
+    realtimeMessages = 0;
+    debugMessages = 0;
+    incompleteMessages = 0;
+    unexpectedDataBytes = 0;
+    unknownStatusBytes = 0;
+    sysExOverflows = 0;
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/**
+ * MidiStreamParser turns the raw serial byte stream into MIDI messages.
+ * Voice and system-common messages are assembled in a fixed 3-byte inline
+ * buffer; SysEx and Hairless debug messages ({ 0xFF, 0, 0, <len>, text })
+ * use a buffer allocated up front. Nothing is allocated while parsing.
+ * Problems in the stream are counted rather than reported as text, so the
+ * parser never formats strings on the hot path.
+ *
+ * Each buffer is scanned for status bytes with SIMD (AVX2 or SSE2 on x86,
+ * NEON on ARM, scalar elsewhere), and the data bytes in between are handled
+ * as runs: SysEx payloads are copied in one go, running-status streams
+ * without a per-byte status test.
+ *
+ * Real-time bytes (0xF8-0xFE) may arrive in the middle of any message,
+ * including SysEx. They are passed to onRealtimeMessage the moment they
+ * are seen and leave the message they interrupted, and the running
+ * status, untouched.
+ *
+ * In SysEx streaming mode, SysEx is not collected. It goes out through
+ * onSysExChunk in pieces of at most the chunk size as the bytes arrive,
+ * with no size limit and no buffer beyond one chunk.
+ *
+ * Single-threaded: parse() and reset() must be called from one thread.
+ * getStats() may be called from any thread.
+ */
+class MidiStreamParser
+{
+public:
+    struct Stats
+    {
+        juce::uint64 messages = 0;              // voice + system messages delivered
+        juce::uint64 sysExMessages = 0;
+        juce::uint64 realtimeMessages = 0;
+        juce::uint64 debugMessages = 0;
+        juce::uint64 incompleteMessages = 0;    // cut short by a status byte, sent anyway
+        juce::uint64 unexpectedDataBytes = 0;   // data with no status to attach to
+        juce::uint64 unknownStatusBytes = 0;
+        juce::uint64 sysExOverflows = 0;        // SysEx longer than the buffer, dropped
+        
+        juce::uint64 getErrorCount() const
+        {
+            return incompleteMessages + unexpectedDataBytes + unknownStatusBytes + sysExOverflows;
+        }
+    };
+    
+    MidiStreamParser();
+    
+    // Largest SysEx message (including F0/F7) that will be delivered.
+    // Allocates, so call it before parsing starts.
+    void setMaxSysExSize(int numBytes);
+    int getMaxSysExSize() const { return maxSysExSize; }
+    
+    // Forward SysEx in chunks through onSysExChunk instead of whole through
+    // onMessage. Call it between sessions, not while parsing.
+    void setSysExStreaming(bool enabled, int chunkSize = 256);
+    bool isSysExStreaming() const { return sysExStreaming; }
+    
+    // Forget any half-parsed message and the running status
+    void reset();
+    
+    // Feed bytes from the stream; callbacks fire as messages complete
+    void parse(const juce::uint8* data, int numBytes);
+    
+    // Stream offset of the next byte parse() will see. Counts up from 0
+    // after reset(); set it when the caller numbers the stream itself.
+    void setStreamPosition(juce::uint64 position) { streamPosition = position; }
+    juce::uint64 getStreamPosition() const { return streamPosition; }
+    
+    // Inside a callback: stream offset of the byte that completed the
+    // message (for a SysEx chunk, the newest byte received). Used to look
+    // up when the message arrived.
+    juce::uint64 getMessagePosition() const { return messagePosition; }
+    
+    // A complete MIDI message. The pointer is only valid during the call.
+    std::function<void(const juce::uint8* data, int size)> onMessage;
+    
+    // A piece of a streamed SysEx message. The first piece starts with 0xF0,
+    // the last (isLast) ends with 0xF7 unless the message was cut short.
+    // Every piece but the first and last is at least 4 bytes, so it can be
+    // wrapped in a juce::MidiMessage.
+    std::function<void(const juce::uint8* data, int size, bool isLast)> onSysExChunk;
+    
+    // A single real-time byte (clock, start/stop, active sensing ...),
+    // delivered ahead of any message it interrupted
+    std::function<void(juce::uint8 byte)> onRealtimeMessage;
+    
+    // The text of a debug message sent by the Arduino library
+    std::function<void(const char* text, int length)> onDebugText;
+    
+    Stats getStats() const;
+    void resetStats();
+    
+    // Which status-byte scanner parse() uses on this machine
+    const char* getScannerName() const { return scannerName; }
+    
+    // Data bytes that follow a status byte, 0 for none, a large value for
+    // SysEx (ends with 0xF7) or -2 if the byte isn't a status byte
+    static int getDataLength(int status);
+    
+    static constexpr juce::uint8 MSG_SYSEX_START = 0xF0;
+    static constexpr juce::uint8 MSG_SYSEX_END = 0xF7;
+    static constexpr juce::uint8 MSG_DEBUG = 0xFF;
+    
+    // 0xFF is a reset on the wire but Hairless uses it for debug messages
+    static bool isRealtimeByte(juce::uint8 byte) { return byte >= 0xF8 && byte < MSG_DEBUG; }
+    
+private:
+    enum class Pending { none, shortMessage, sysEx, debug };
+    
+    void handleStatusByte(juce::uint8 byte);
+    void handleDataByte(juce::uint8 byte);
+    void consumeDataRun(const juce::uint8* data, int numBytes, juce::uint64 position);
+    void appendLong(juce::uint8 byte);
+    void appendLongRun(const juce::uint8* data, int numBytes, juce::uint64 position);
+    void flushSysExChunk(bool isLast);
+    void emit();
+    
+    // Single writer (the parsing thread), so no read-modify-write needed
+    static void bump(std::atomic<juce::uint64>& counter, int amount = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + static_cast<juce::uint64>(amount),
+                      std::memory_order_relaxed);
+    }
+    
+    // Index of the first byte with the top bit set, or numBytes if none
+    using StatusScanner = int (*)(const juce::uint8* data, int numBytes);
+    StatusScanner findStatusByte = nullptr;
+    const char* scannerName = "scalar";
+    
+    // Message being assembled
+    Pending pending = Pending::none;
+    juce::uint8 shortMessage[3] = {};
+    int shortSize = 0;
+    juce::HeapBlock<juce::uint8> longMessage;
+    int longSize = 0;
+    bool longOverflowed = false;
+    int dataExpected = 0;
+    juce::uint8 runningStatus = 0;
+    
+    int maxSysExSize = 0;
+    int longCapacity = 0;
+    
+    juce::uint64 streamPosition = 0;
+    juce::uint64 messagePosition = 0;
+    
+    bool sysExStreaming = false;
+    int sysExChunkSize = 256;
+    bool sysExChunkSent = false;    // the current message's first chunk is out
+    
+    std::atomic<juce::uint64> messages { 0 };
+    std::atomic<juce::uint64> sysExMessages { 0 };
+    std::atomic<juce::uint64> realtimeMessages { 0 };
+    std::atomic<juce::uint64> debugMessages { 0 };
+    std::atomic<juce::uint64> incompleteMessages { 0 };
+    std::atomic<juce::uint64> unexpectedDataBytes { 0 };
+    std::atomic<juce::uint64> unknownStatusBytes { 0 };
+    std::atomic<juce::uint64> sysExOverflows { 0 };
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiStreamParser)
+};
@@ -0,0 +1,491 @@
+#include "NativeSerialTransport.h"
+
+#if JUCE_WINDOWS
+    #include <windows.h>
+#elif JUCE_MAC
+    #include <fcntl.h>
+    #include <termios.h>
+    #include <unistd.h>
+    #include <IOKit/serial/ioss.h>
+    #include <poll.h>
+    #include <errno.h>
+    #include <sys/ioctl.h>
+#elif JUCE_LINUX
+    #include <sys/ioctl.h>
+    #include <fcntl.h>
+    #include <termios.h>
+    #include <unistd.h>
+    #include <poll.h>
+    #include <errno.h>
+    #include <limits.h>
+    #include <stdlib.h>
+    #include <linux/serial.h>
+    
+    #include "LinuxCustomBaud.h"
+#endif
+
+#if JUCE_MAC || JUCE_LINUX
+// Map a baud rate to its termios constant, or B0 if there isn't one
+static speed_t toSpeedConstant(int baudRate)
+{
+    switch (baudRate)
+    {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+       #ifdef B230400
+        case 230400: return B230400;
+       #endif
+       #ifdef B460800
+        case 460800: return B460800;
+       #endif
+       #ifdef B500000
+        case 500000: return B500000;
+       #endif
+       #ifdef B921600
+        case 921600: return B921600;
+       #endif
+       #ifdef B1000000
+        case 1000000: return B1000000;
+       #endif
+       #ifdef B2000000
+        case 2000000: return B2000000;
+       #endif
+        default: return B0;
+    }
+}
+
+// Apply a rate that has no termios constant (e.g. 31250 for DIN MIDI).
+// On success effectiveBaud holds the rate the driver actually accepted.
+static bool setCustomBaudRate(int fd, int baudRate, int& effectiveBaud)
+{
+   #if JUCE_LINUX
+    return setLinuxCustomBaudRate(fd, baudRate, effectiveBaud);
+   #elif JUCE_MAC
+    speed_t speed = static_cast<speed_t>(baudRate);
+    
+    if (ioctl(fd, IOSSIOSPEED, &speed) != 0)
+        return false;
+    
+    effectiveBaud = baudRate;
+    return true;
+   #else
+    juce::ignoreUnused(fd, baudRate, effectiveBaud);
+    return false;
+   #endif
+}
+#endif
+
+//==============================================================================
+#if JUCE_WINDOWS
+std::unique_ptr<NativeSerialTransport> NativeSerialTransport::open(const juce::String& portName, const Options& options)
+{
+    juce::String portPath = "\\\\.\\" + portName;
+    
+    HANDLE handle = CreateFileA(portPath.toRawUTF8(),
+                                 GENERIC_READ | GENERIC_WRITE,
+                                 0,
+                                 0,
+                                 OPEN_EXISTING,
+                                 FILE_FLAG_OVERLAPPED,
+                                 0);
+    
+    if (handle == INVALID_HANDLE_VALUE)
+        return nullptr;
+    
+    DCB dcb;
+    memset(&dcb, 0, sizeof(DCB));
+    dcb.DCBlength = sizeof(DCB);
+    
+    if (!GetCommState(handle, &dcb))
+    {
+        CloseHandle(handle);
+        return nullptr;
+    }
+    
+    dcb.BaudRate = options.baudRate;
+    dcb.ByteSize = 8;
+    dcb.Parity = NOPARITY;
+    dcb.StopBits = ONESTOPBIT;
+    
+    if (!SetCommState(handle, &dcb))
+    {
+        CloseHandle(handle);
+        return nullptr;
+    }
+    
+    // The driver may round the requested rate
+    int effectiveBaud = options.baudRate;
+    if (GetCommState(handle, &dcb))
+        effectiveBaud = static_cast<int>(dcb.BaudRate);
+    
+    // Overlapped reads with MAXDWORD interval timeout already return
+    // immediately; the other low-latency settings are POSIX-only
+    COMMTIMEOUTS timeouts;
+    timeouts.ReadIntervalTimeout = MAXDWORD;
+    timeouts.ReadTotalTimeoutMultiplier = 0;
+    timeouts.ReadTotalTimeoutConstant = 0;
+    timeouts.WriteTotalTimeoutMultiplier = 0;
+    timeouts.WriteTotalTimeoutConstant = 0;
+    SetCommTimeouts(handle, &timeouts);
+    SetCommMask(handle, EV_RXCHAR);
+    
+    std::unique_ptr<NativeSerialTransport> transport(new NativeSerialTransport(handle, effectiveBaud));
+    transport->lowLatencyStatus.requested = options.lowLatency;
+    return transport;
+}
+
+NativeSerialTransport::NativeSerialTransport(void* h, int effectiveBaud)
+    : handle(h),
+      overlappedWait(nullptr),
+      wakeEvent(CreateEvent(NULL, FALSE, FALSE, NULL)),
+      baudRate(effectiveBaud)
+{
+    auto* waitOverlapped = new OVERLAPPED();
+    waitOverlapped->hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    overlappedWait = waitOverlapped;
+}
+
+NativeSerialTransport::~NativeSerialTransport()
+{
+    CloseHandle(static_cast<HANDLE>(handle));
+    
+    if (auto* waitOverlapped = static_cast<OVERLAPPED*>(overlappedWait))
+    {
+        CloseHandle(waitOverlapped->hEvent);
+        delete waitOverlapped;
+    }
+    
+    if (wakeEvent != nullptr)
+        CloseHandle(static_cast<HANDLE>(wakeEvent));
+}
+
+int NativeSerialTransport::read(juce::uint8* buffer, int maxBytes)
+{
+    DWORD bytesRead = 0;
+    OVERLAPPED overlapped = {0};
+    overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    
+    if (ReadFile(static_cast<HANDLE>(handle), buffer, maxBytes, &bytesRead, &overlapped))
+    {
+        CloseHandle(overlapped.hEvent);
+        return bytesRead;
+    }
+    
+    if (GetLastError() == ERROR_IO_PENDING)
+    {
+        if (GetOverlappedResult(static_cast<HANDLE>(handle), &overlapped, &bytesRead, TRUE))
+        {
+            CloseHandle(overlapped.hEvent);
+            return bytesRead;
+        }
+    }
+    
+    CloseHandle(overlapped.hEvent);
+    return -1;
+}
+
+int NativeSerialTransport::write(const juce::uint8* data, int numBytes)
+{
+    DWORD bytesWritten = 0;
+    OVERLAPPED overlapped = {0};
+    overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    
+    if (WriteFile(static_cast<HANDLE>(handle), data, numBytes, &bytesWritten, &overlapped))
+    {
+        CloseHandle(overlapped.hEvent);
+        return bytesWritten;
+    }
+    
+    if (GetLastError() == ERROR_IO_PENDING)
+    {
+        if (GetOverlappedResult(static_cast<HANDLE>(handle), &overlapped, &bytesWritten, TRUE))
+        {
+            CloseHandle(overlapped.hEvent);
+            return bytesWritten;
+        }
+    }
+    
+    CloseHandle(overlapped.hEvent);
+    return -1;
+}
+
+int NativeSerialTransport::waitForData(int timeoutMs)
+{
+    if (bytesAvailable() > 0)
+        return 1;
+    
+    auto h = static_cast<HANDLE>(handle);
+    auto* waitOverlapped = static_cast<OVERLAPPED*>(overlappedWait);
+    DWORD eventMask = 0;
+    DWORD transferred = 0;
+    
+    ResetEvent(waitOverlapped->hEvent);
+    
+    if (!WaitCommEvent(h, &eventMask, waitOverlapped))
+    {
+        if (GetLastError() != ERROR_IO_PENDING)
+            return -1;
+        
+        HANDLE events[] = { waitOverlapped->hEvent, static_cast<HANDLE>(wakeEvent) };
+        DWORD result = WaitForMultipleObjects(2, events, FALSE, static_cast<DWORD>(timeoutMs));
+        
+        if (result != WAIT_OBJECT_0)
+        {
+            // Resetting the mask completes the pending WaitCommEvent
+            SetCommMask(h, EV_RXCHAR);
+            GetOverlappedResult(h, waitOverlapped, &transferred, TRUE);
+            return (result == WAIT_TIMEOUT || result == WAIT_OBJECT_0 + 1) ? 0 : -1;
+        }
+        
+        if (!GetOverlappedResult(h, waitOverlapped, &transferred, FALSE))
+            return -1;
+    }
+    
+    return ((eventMask & EV_RXCHAR) != 0 || bytesAvailable() > 0) ? 1 : 0;
+}
+
+void NativeSerialTransport::wake()
+{
+    if (wakeEvent != nullptr)
+        SetEvent(static_cast<HANDLE>(wakeEvent));
+}
+
+bool NativeSerialTransport::waitForWritable(int timeoutMs)
+{
+    // Overlapped writes already wait for completion
+    juce::Thread::sleep(juce::jmin(timeoutMs, 1));
+    return true;
+}
+
+int NativeSerialTransport::bytesAvailable()
+{
+    COMSTAT comStat;
+    DWORD errors;
+    
+    if (ClearCommError(static_cast<HANDLE>(handle), &errors, &comStat))
+        return comStat.cbInQue;
+    
+    return 0;
+}
+
+//==============================================================================
+#else
+std::unique_ptr<NativeSerialTransport> NativeSerialTransport::open(const juce::String& portName, const Options& options)
+{
+    int portFd = ::open(portName.toRawUTF8(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    
+    if (portFd == -1)
+        return nullptr;
+    
+    struct termios tio;
+    tcgetattr(portFd, &tio);
+    
+    // Set baud rate. Non-standard rates start from a placeholder
+    // constant and are then applied with setCustomBaudRate()
+    speed_t speed = toSpeedConstant(options.baudRate);
+    
+    cfsetispeed(&tio, speed != B0 ? speed : B38400);
+    cfsetospeed(&tio, speed != B0 ? speed : B38400);
+    
+    // 8N1
+    tio.c_cflag &= ~PARENB;
+    tio.c_cflag &= ~CSTOPB;
+    tio.c_cflag &= ~CSIZE;
+    tio.c_cflag |= CS8;
+    
+    // Raw input
+    tio.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
+    tio.c_oflag &= ~OPOST;
+    
+    tcsetattr(portFd, TCSANOW, &tio);
+    
+    int effectiveBaud = options.baudRate;
+    
+    if (speed == B0 && !setCustomBaudRate(portFd, options.baudRate, effectiveBaud))
+    {
+        ::close(portFd);
+        return nullptr;
+    }
+    
+    std::unique_ptr<NativeSerialTransport> transport(new NativeSerialTransport(portFd, effectiveBaud));
+    transport->applyLowLatencySettings(portName, options);
+    return transport;
+}
+
+NativeSerialTransport::NativeSerialTransport(int fileDescriptor, int effectiveBaud)
+    : fd(fileDescriptor),
+      baudRate(effectiveBaud)
+{
+    wakePipe[0] = wakePipe[1] = -1;
+    
+    if (pipe(wakePipe) == 0)
+    {
+        fcntl(wakePipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakePipe[1], F_SETFL, O_NONBLOCK);
+    }
+}
+
+NativeSerialTransport::~NativeSerialTransport()
+{
+    ::close(fd);
+    
+    for (int pipeFd : wakePipe)
+        if (pipeFd >= 0)
+            ::close(pipeFd);
+}
+
+void NativeSerialTransport::applyLowLatencySettings(const juce::String& portName, const Options& options)
+{
+    lowLatencyStatus.requested = options.lowLatency;
+    
+    struct termios tio;
+    
+    if (options.lowLatency && tcgetattr(fd, &tio) == 0)
+    {
+        // Reads return whatever is there; poll() does the waiting
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        lowLatencyStatus.vmin = tio.c_cc[VMIN];
+        lowLatencyStatus.vtime = tio.c_cc[VTIME];
+    }
+   
+   #if JUCE_LINUX
+    struct serial_struct serial;
+    
+    if (ioctl(fd, TIOCGSERIAL, &serial) == 0)
+    {
+        if (options.lowLatency && (serial.flags & ASYNC_LOW_LATENCY) == 0)
+        {
+            serial.flags |= ASYNC_LOW_LATENCY;
+            ioctl(fd, TIOCSSERIAL, &serial);
+            ioctl(fd, TIOCGSERIAL, &serial);
+        }
+        
+        lowLatencyStatus.asyncLowLatency = (serial.flags & ASYNC_LOW_LATENCY) != 0;
+    }
+    
+    // USB-serial adapters expose the latency timer in sysfs, keyed by the
+    // kernel tty name (resolve /dev/serial/by-id links first)
+    char resolved[PATH_MAX];
+    juce::String ttyName = juce::File(realpath(portName.toRawUTF8(), resolved) != nullptr
+                                          ? juce::String(resolved) : portName).getFileName();
+    juce::String timerPath = "/sys/bus/usb-serial/devices/" + ttyName + "/latency_timer";
+    
+    if (options.lowLatency)
+    {
+        int timerFd = ::open(timerPath.toRawUTF8(), O_WRONLY);
+        
+        if (timerFd >= 0)
+        {
+            juce::String value(options.latencyTimerMs);
+            juce::ignoreUnused(::write(timerFd, value.toRawUTF8(), static_cast<size_t>(value.length())));
+            ::close(timerFd);
+        }
+    }
+    
+    juce::File timerFile(timerPath);
+    if (timerFile.existsAsFile())
+        lowLatencyStatus.latencyTimerMs = timerFile.loadFileAsString().trim().getIntValue();
+   
+   #elif JUCE_MAC
+    if (options.lowLatency)
+    {
+        // Receive latency in microseconds
+        unsigned long latencyUs = static_cast<unsigned long>(options.latencyTimerMs) * 1000;
+        
+        if (ioctl(fd, IOSSDATALAT, &latencyUs) == 0)
+            lowLatencyStatus.latencyTimerMs = options.latencyTimerMs;
+    }
+    
+    juce::ignoreUnused(portName);
+   #endif
+}
+
+int NativeSerialTransport::read(juce::uint8* buffer, int maxBytes)
+{
+    const ssize_t result = ::read(fd, buffer, static_cast<size_t>(maxBytes));
+    
+    if (result > 0)
+        return static_cast<int>(result);
+    
+    // Only called once poll() said readable: 0 means hangup
+    if (result == 0 || (errno != EAGAIN && errno != EINTR))
+        return -1;
+    
+    return 0;
+}
+
+int NativeSerialTransport::write(const juce::uint8* data, int numBytes)
+{
+    const ssize_t result = ::write(fd, data, static_cast<size_t>(numBytes));
+    
+    if (result >= 0)
+        return static_cast<int>(result);
+    
+    return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+}
+
+int NativeSerialTransport::waitForData(int timeoutMs)
+{
+    struct pollfd fds[2];
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = wakePipe[0];
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+    
+    int result = ::poll(fds, 2, timeoutMs);
+    
+    if (result < 0)
+        return errno == EINTR ? 0 : -1;
+    
+    if (fds[1].revents & POLLIN)
+    {
+        char drain[16];
+        while (::read(wakePipe[0], drain, sizeof(drain)) > 0) {}
+    }
+    
+    if (fds[0].revents & POLLIN)
+        return 1;
+    
+    if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL))
+        return -1;
+    
+    return 0;
+}
+
+void NativeSerialTransport::wake()
+{
+    if (wakePipe[1] >= 0)
+    {
+        const char token = 0;
+        juce::ignoreUnused(::write(wakePipe[1], &token, 1));
+    }
+}
+
+bool NativeSerialTransport::waitForWritable(int timeoutMs)
+{
+    struct pollfd fds;
+    fds.fd = fd;
+    fds.events = POLLOUT;
+    fds.revents = 0;
+    
+    return ::poll(&fds, 1, timeoutMs) > 0 && (fds.revents & POLLOUT) != 0;
+}
+
+int NativeSerialTransport::bytesAvailable()
+{
+    int bytes = 0;
+    ioctl(fd, FIONREAD, &bytes);
+    return bytes;
+}
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "SerialTransport.h"
+
+/**
+ * A real serial device: Win32 overlapped I/O on Windows, a non-blocking
+ * termios file descriptor on macOS/Linux
+ */
+class NativeSerialTransport : public SerialTransport
+{
+public:
+    // Open and configure the device (8N1, raw). Any positive baud rate is
+    // accepted; rates without a standard constant (e.g. 31250, 250000)
+    // use the platform's custom-rate mechanism (termios2/BOTHER on Linux,
+    // IOSSIOSPEED on macOS). Returns nullptr rather than silently falling
+    // back if the driver refuses the rate.
+    static std::unique_ptr<NativeSerialTransport> open(const juce::String& portName, const Options& options);
+    
+    ~NativeSerialTransport() override;
+    
+    int read(juce::uint8* buffer, int maxBytes) override;
+    int write(const juce::uint8* data, int numBytes) override;
+    int waitForData(int timeoutMs) override;
+    void wake() override;
+    bool waitForWritable(int timeoutMs) override;
+    int bytesAvailable() override;
+    int getBaudRate() const override { return baudRate; }
+    LowLatencyStatus getLowLatencyStatus() const override { return lowLatencyStatus; }
+    
+protected:
+#if ! JUCE_WINDOWS
+    // Take ownership of an already configured, non-blocking descriptor
+    NativeSerialTransport(int fileDescriptor, int effectiveBaud);
+    
+    int fd = -1;
+#endif
+
+private:
+#if JUCE_WINDOWS
+    NativeSerialTransport(void* handle, int effectiveBaud);
+    
+    void* handle;
+    void* overlappedWait;
+    void* wakeEvent;
+#else
+    // Apply low-latency settings to the freshly opened fd and record the
+    // effective values in lowLatencyStatus
+    void applyLowLatencySettings(const juce::String& portName, const Options& options);
+    
+    int wakePipe[2];
+#endif
+
+    int baudRate;
+    LowLatencyStatus lowLatencyStatus;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NativeSerialTransport)
+};
@@ -0,0 +1,43 @@
+#include "NoteStateTracker.h"
+
+NoteStateTracker::NoteStateTracker()
+{
+    clear();
+}
+
+void NoteStateTracker::noteOn(int channel0, int note, int outChannel0, int outNote)
+{
+    clearBit(suppressedBits[channel0], note);
+    setBit(soundingBits[channel0], note);
+    sounding[channel0][note] = static_cast<juce::uint16>((outChannel0 << 8) | outNote);
+}
+
+void NoteStateTracker::noteSuppressed(int channel0, int note)
+{
+    clearBit(soundingBits[channel0], note);
+    setBit(suppressedBits[channel0], note);
+}
+
+NoteStateTracker::Release NoteStateTracker::noteOff(int channel0, int note, int& outChannel0, int& outNote)
+{
+    if (testBit(suppressedBits[channel0], note))
+    {
+        clearBit(suppressedBits[channel0], note);
+        return Release::suppressed;
+    }
+    
+    if (! testBit(soundingBits[channel0], note))
+        return Release::notTracked;
+    
+    clearBit(soundingBits[channel0], note);
+    outChannel0 = sounding[channel0][note] >> 8;
+    outNote = sounding[channel0][note] & 0x7F;
+    return Release::mapped;
+}
+
+void NoteStateTracker::clear()
+{
+    juce::zeromem(soundingBits, sizeof(soundingBits));
+    juce::zeromem(suppressedBits, sizeof(suppressedBits));
+    juce::zeromem(sounding, sizeof(sounding));
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/**
+ * NoteStateTracker remembers, for every incoming channel and note, what its
+ * Note On turned into: the output channel and note that is now sounding,
+ * or that it was suppressed. The matching Note Off is then mapped from
+ * this record rather than from the current settings, so changing a shift,
+ * the scale or the output channel mid-note can't leave a note hanging.
+ *
+ * Fixed-size (16 x 128 entries plus bitsets): nothing is allocated or
+ * rehashed on the MIDI path.
+ */
+class NoteStateTracker
+{
+public:
+    // What a Note Off should become
+    enum class Release
+    {
+        notTracked,     // no Note On seen (e.g. it came before the bridge started)
+        suppressed,     // the Note On was dropped, drop this too
+        mapped          // send a Note Off for outChannel0 / outNote
+    };
+    
+    NoteStateTracker();
+    
+    // Record a Note On that was sent as outNote on outChannel0
+    void noteOn(int channel0, int note, int outChannel0, int outNote);
+    
+    // Record a Note On that was dropped
+    void noteSuppressed(int channel0, int note);
+    
+    // Look up and forget the record for a Note Off
+    Release noteOff(int channel0, int note, int& outChannel0, int& outNote);
+    
+    // Forget everything
+    void clear();
+    
+    bool isSounding(int channel0, int note) const { return testBit(soundingBits[channel0], note); }
+    
+    // Call fn(outChannel0, outNote) for every note still sounding
+    template <typename Callback>
+    void forEachSoundingNote(Callback&& fn) const
+    {
+        for (int channel0 = 0; channel0 < 16; ++channel0)
+        {
+            if ((soundingBits[channel0][0] | soundingBits[channel0][1]) == 0)
+                continue;
+            
+            for (int note = 0; note < 128; ++note)
+            {
+                if (testBit(soundingBits[channel0], note))
+                    fn(sounding[channel0][note] >> 8, sounding[channel0][note] & 0x7F);
+            }
+        }
+    }
+    
+private:
+    static void setBit(juce::uint64 (&bits)[2], int note)   { bits[note >> 6] |= juce::uint64(1) << (note & 63); }
+    static void clearBit(juce::uint64 (&bits)[2], int note) { bits[note >> 6] &= ~(juce::uint64(1) << (note & 63)); }
+    static bool testBit(const juce::uint64 (&bits)[2], int note) { return (bits[note >> 6] >> (note & 63)) & 1; }
+    
+    juce::uint64 soundingBits[16][2];
+    juce::uint64 suppressedBits[16][2];
+    juce::uint16 sounding[16][128];     // (outChannel0 << 8) | outNote, valid where soundingBits is set
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoteStateTracker)
+};
@@ -0,0 +1,49 @@
+#include "PseudoTerminalTransport.h"
+
+#if ! JUCE_WINDOWS
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#if JUCE_MAC
+    #include <util.h>
+#else
+    #include <pty.h>
+#endif
+
+std::unique_ptr<PseudoTerminalTransport> PseudoTerminalTransport::open(const Options& options)
+{
+    int masterFd = -1, slaveFd = -1;
+    char slaveName[256] = {};
+    
+    if (openpty(&masterFd, &slaveFd, slaveName, nullptr, nullptr) != 0)
+        return nullptr;
+    
+    // Raw on both sides so bytes pass through untouched
+    struct termios tio;
+    if (tcgetattr(slaveFd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(slaveFd, TCSANOW, &tio);
+    }
+    
+    fcntl(masterFd, F_SETFL, fcntl(masterFd, F_GETFL) | O_NONBLOCK);
+    
+    return std::unique_ptr<PseudoTerminalTransport>(
+        new PseudoTerminalTransport(masterFd, slaveFd, juce::String(slaveName), options.baudRate));
+}
+
+PseudoTerminalTransport::PseudoTerminalTransport(int masterFd, int slave, const juce::String& path, int nominalBaud)
+    : NativeSerialTransport(masterFd, nominalBaud),
+      slaveFd(slave),
+      slavePath(path)
+{
+}
+
+PseudoTerminalTransport::~PseudoTerminalTransport()
+{
+    ::close(slaveFd);
+}
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "NativeSerialTransport.h"
+
+#if ! JUCE_WINDOWS
+
+/**
+ * Pseudo-terminal loopback (POSIX only). The transport owns the master
+ * side; a device simulator opens getPeerPath() to feed it traffic, so the
+ * whole pipeline can run without USB hardware.
+ */
+class PseudoTerminalTransport : public NativeSerialTransport
+{
+public:
+    // There is no line rate: the nominal baudRate is only remembered for
+    // timing estimates
+    static std::unique_ptr<PseudoTerminalTransport> open(const Options& options);
+    
+    ~PseudoTerminalTransport() override;
+    
+    juce::String getPeerPath() const override { return slavePath; }
+    
+private:
+    PseudoTerminalTransport(int masterFd, int slaveFd, const juce::String& slavePath, int nominalBaud);
+    
+    int slaveFd;    // kept open so the master never sees a hangup
+    juce::String slavePath;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PseudoTerminalTransport)
+};
+
+#endif
@@ -0,0 +1,204 @@
+#include "RealtimeThreading.h"
+
+#if JUCE_WINDOWS
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <errno.h>
+    #include <string.h>
+#endif
+
+// Stack each I/O thread touches up front when memory is locked
+static constexpr size_t prefaultStackBytes = 64 * 1024;
+
+static void prefaultStack()
+{
+    volatile juce::uint8 stack[prefaultStackBytes];
+    
+    for (size_t i = 0; i < prefaultStackBytes; i += 4096)
+        stack[i] = 0;
+    
+    juce::ignoreUnused(stack);
+}
+
+#if ! JUCE_WINDOWS
+static const char* describePolicy(int policy)
+{
+    switch (policy)
+    {
+        case SCHED_FIFO:  return "SCHED_FIFO";
+        case SCHED_RR:    return "SCHED_RR";
+        case SCHED_OTHER: return "SCHED_OTHER";
+        default:          return "other policy";
+    }
+}
+#endif
+
+#if JUCE_LINUX
+// CPUs 0-63 that are online, from the kernel's "0-3,6" style list. All of
+// them if it can't be read.
+static juce::uint64 onlineCpuMask()
+{
+    const auto text = juce::File("/sys/devices/system/cpu/online").loadFileAsString().trim();
+    juce::uint64 mask = 0;
+    
+    for (auto item : juce::StringArray::fromTokens(text, ",", ""))
+    {
+        const int first = item.upToFirstOccurrenceOf("-", false, false).getIntValue();
+        const int last = item.contains("-") ? item.fromFirstOccurrenceOf("-", false, false).getIntValue() : first;
+        
+        for (int cpu = juce::jmax(0, first); cpu <= juce::jmin(63, last); ++cpu)
+            mask |= juce::uint64(1) << cpu;
+    }
+    
+    return mask != 0 ? mask : ~juce::uint64(0);
+}
+#endif
+
+RealtimeThreading::Report RealtimeThreading::applyToCurrentThread(const juce::String& threadName,
+                                                                  const RealtimeOptions& options)
+{
+    Report report;
+    report.threadName = threadName;
+    juce::StringArray parts;
+    
+    if (options.policy != RealtimeOptions::Policy::normal)
+    {
+       #if JUCE_WINDOWS
+        // Windows has no user-visible FIFO/RR distinction; time-critical is
+        // the top of the normal classes
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+        report.schedulingApplied = GetThreadPriority(GetCurrentThread()) == THREAD_PRIORITY_TIME_CRITICAL;
+        parts.add(report.schedulingApplied ? "time-critical priority" : "time-critical priority refused");
+       #else
+        const int policy = options.policy == RealtimeOptions::Policy::fifo ? SCHED_FIFO : SCHED_RR;
+        
+        sched_param param {};
+        param.sched_priority = juce::jlimit(sched_get_priority_min(policy), sched_get_priority_max(policy),
+                                            options.priority);
+        
+        const int error = pthread_setschedparam(pthread_self(), policy, &param);
+        
+        int actualPolicy = SCHED_OTHER;
+        sched_param actual {};
+        pthread_getschedparam(pthread_self(), &actualPolicy, &actual);
+        
+        report.schedulingApplied = error == 0 && actualPolicy == policy
+                                    && actual.sched_priority == param.sched_priority;
+        
+        if (report.schedulingApplied)
+            parts.add(juce::String(describePolicy(policy)) + " priority " + juce::String(actual.sched_priority));
+        else
+            parts.add(juce::String("wanted ") + describePolicy(policy) + " priority " + juce::String(param.sched_priority)
+                      + ", running " + describePolicy(actualPolicy)
+                      + (error != 0 ? " (" + juce::String(strerror(error)) + ")" : juce::String()));
+       #endif
+    }
+    
+    if (options.cpuMask != 0)
+    {
+       #if JUCE_WINDOWS
+        report.affinityApplied = SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(options.cpuMask)) != 0;
+       #elif JUCE_LINUX
+        cpu_set_t wanted;
+        CPU_ZERO(&wanted);
+        
+        for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu)
+            if ((options.cpuMask >> cpu) & 1)
+                CPU_SET(cpu, &wanted);
+        
+        // The kernel leaves offline CPUs out of the mask it applies, so
+        // that is what the result is compared against
+        cpu_set_t expected;
+        CPU_ZERO(&expected);
+        
+        const juce::uint64 online = onlineCpuMask();
+        
+        for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu)
+            if ((options.cpuMask >> cpu) & (online >> cpu) & 1)
+                CPU_SET(cpu, &expected);
+        
+        cpu_set_t actual;
+        CPU_ZERO(&actual);
+        
+        report.affinityApplied = pthread_setaffinity_np(pthread_self(), sizeof(wanted), &wanted) == 0
+                                  && pthread_getaffinity_np(pthread_self(), sizeof(actual), &actual) == 0
+                                  && CPU_EQUAL(&expected, &actual);
+       #else
+        // macOS only has affinity tags, which are hints
+        report.affinityApplied = false;
+       #endif
+       
+        parts.add((report.affinityApplied ? "CPUs " : "pinning to CPUs refused: ")
+                  + describeCpuMask(options.cpuMask));
+        
+       #if JUCE_LINUX
+        if (report.affinityApplied && (options.cpuMask & ~online) != 0)
+            parts.add("offline: " + describeCpuMask(options.cpuMask & ~online));
+       #endif
+    }
+    
+    if (options.lockMemory)
+        prefaultStack();
+    
+    report.description = parts.joinIntoString(", ");
+    return report;
+}
+
+bool RealtimeThreading::lockProcessMemory(juce::String& errorMessage)
+{
+   #if JUCE_LINUX
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+        return true;
+    
+    errorMessage = juce::String(strerror(errno)) + " (raise the memlock limit, e.g. ulimit -l)";
+    return false;
+   #else
+    errorMessage = "not supported on this platform";
+    return false;
+   #endif
+}
+
+void RealtimeThreading::prefault(void* data, size_t numBytes)
+{
+    if (data != nullptr)
+        memset(data, 0, numBytes);
+}
+
+bool RealtimeThreading::parseCpuList(const juce::String& text, juce::uint64& cpuMask)
+{
+    juce::uint64 mask = 0;
+    
+    for (auto item : juce::StringArray::fromTokens(text, ",", ""))
+    {
+        item = item.trim();
+        
+        if (! item.containsOnly("0123456789-") || item.isEmpty())
+            return false;
+        
+        const int first = item.upToFirstOccurrenceOf("-", false, false).getIntValue();
+        const int last = item.contains("-") ? item.fromFirstOccurrenceOf("-", false, false).getIntValue() : first;
+        
+        if (first < 0 || last < first || last > 63)
+            return false;
+        
+        for (int cpu = first; cpu <= last; ++cpu)
+            mask |= juce::uint64(1) << cpu;
+    }
+    
+    cpuMask = mask;
+    return mask != 0;
+}
+
+juce::String RealtimeThreading::describeCpuMask(juce::uint64 cpuMask)
+{
+    juce::StringArray cpus;
+    
+    for (int cpu = 0; cpu < 64; ++cpu)
+        if ((cpuMask >> cpu) & 1)
+            cpus.add(juce::String(cpu));
+    
+    return cpus.joinIntoString(",");
+}
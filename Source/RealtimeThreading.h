@@ -0,0 +1,56 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/**
+ * Scheduling for the bridge I/O threads (serial reader, writer, dispatch
+ * and output scheduler). A thread applies the options to itself when it
+ * starts and reports what it actually got, because real-time policies are
+ * routinely refused (Linux needs CAP_SYS_NICE or an rtprio limit, see
+ * /etc/security/limits.conf).
+ *
+ *   Linux    SCHED_FIFO/SCHED_RR, pthread affinity, mlockall
+ *   macOS    SCHED_FIFO/SCHED_RR; no pinning or memory locking
+ *   Windows  THREAD_PRIORITY_TIME_CRITICAL, SetThreadAffinityMask
+ */
+struct RealtimeOptions
+{
+    enum class Policy { normal, fifo, roundRobin };
+    
+    Policy policy = Policy::normal;
+    int priority = 70;              // 1..99 for fifo/roundRobin
+    juce::uint64 cpuMask = 0;       // bit n = CPU n; 0 leaves affinity alone
+    bool lockMemory = false;        // mlockall, prefault buffers and stacks
+    
+    bool isDefault() const { return policy == Policy::normal && cpuMask == 0 && ! lockMemory; }
+};
+
+class RealtimeThreading
+{
+public:
+    // What a thread asked for and what it is running with now
+    struct Report
+    {
+        juce::String threadName;
+        bool schedulingApplied = true;
+        bool affinityApplied = true;
+        juce::String description;   // e.g. "SCHED_FIFO priority 80, CPUs 2,3"
+        
+        bool isOk() const { return schedulingApplied && affinityApplied; }
+    };
+    
+    // Apply the options to the calling thread and read them back
+    static Report applyToCurrentThread(const juce::String& threadName, const RealtimeOptions& options);
+    
+    // Lock the process's current and future pages into RAM. Returns false
+    // with a reason if the platform or the memlock limit doesn't allow it.
+    static bool lockProcessMemory(juce::String& errorMessage);
+    
+    // Touch every page of a buffer so the first real access doesn't fault
+    static void prefault(void* data, size_t numBytes);
+    
+    // "2,3" / "0-3,6" <-> cpuMask (CPUs 0..63). parseCpuList returns false
+    // on anything it doesn't understand.
+    static bool parseCpuList(const juce::String& text, juce::uint64& cpuMask);
+    static juce::String describeCpuMask(juce::uint64 cpuMask);
+};
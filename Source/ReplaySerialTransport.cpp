@@ -0,0 +1,89 @@
+#include "ReplaySerialTransport.h"
+
+std::unique_ptr<ReplaySerialTransport> ReplaySerialTransport::open(const juce::String& url, const Options& options)
+{
+    auto path = url.fromFirstOccurrenceOf(replayPrefix, false, true);
+    
+    if (options.baudRate <= 0 || ! juce::File::isAbsolutePath(path))
+        return nullptr;
+    
+    auto stream = std::make_unique<juce::FileInputStream>(juce::File(path));
+    
+    if (stream->failedToOpen())
+        return nullptr;
+    
+    return std::unique_ptr<ReplaySerialTransport>(new ReplaySerialTransport(std::move(stream), options.baudRate));
+}
+
+ReplaySerialTransport::ReplaySerialTransport(std::unique_ptr<juce::FileInputStream> s, int nominalBaud)
+    : stream(std::move(s)),
+      startTimeMs(juce::Time::getMillisecondCounterHiRes()),
+      baudRate(nominalBaud)
+{
+}
+
+int ReplaySerialTransport::getBytesDue() const
+{
+    // 8N1: start bit + 8 data bits + stop bit per byte
+    const double elapsedMs = juce::Time::getMillisecondCounterHiRes() - startTimeMs;
+    const auto lineBytes = static_cast<juce::int64>(elapsedMs * baudRate / 10000.0);
+    const auto remaining = stream->getTotalLength() - stream->getPosition();
+    
+    return static_cast<int>(juce::jlimit<juce::int64>(0, 1 << 20, juce::jmin(lineBytes - bytesDelivered, remaining)));
+}
+
+int ReplaySerialTransport::read(juce::uint8* buffer, int maxBytes)
+{
+    const int count = juce::jmin(maxBytes, getBytesDue());
+    
+    if (count <= 0)
+        return 0;
+    
+    const int result = stream->read(buffer, count);
+    bytesDelivered += juce::jmax(0, result);
+    return juce::jmax(0, result);
+}
+
+int ReplaySerialTransport::write(const juce::uint8* data, int numBytes)
+{
+    juce::ignoreUnused(data);
+    return numBytes;
+}
+
+int ReplaySerialTransport::waitForData(int timeoutMs)
+{
+    if (getBytesDue() > 0)
+        return 1;
+    
+    if (stream->isExhausted())
+    {
+        wakeEvent.wait(timeoutMs);
+        return 0;
+    }
+    
+    // Sleep until the next byte is due on the line
+    const double msPerByte = 10000.0 / baudRate;
+    const double nextDueMs = startTimeMs + static_cast<double>(bytesDelivered + 1) * msPerByte;
+    const int untilDue = static_cast<int>(std::ceil(nextDueMs - juce::Time::getMillisecondCounterHiRes()));
+    
+    if (wakeEvent.wait(juce::jlimit(0, timeoutMs, untilDue)))
+        return 0;
+    
+    return getBytesDue() > 0 ? 1 : 0;
+}
+
+void ReplaySerialTransport::wake()
+{
+    wakeEvent.signal();
+}
+
+bool ReplaySerialTransport::waitForWritable(int timeoutMs)
+{
+    juce::ignoreUnused(timeoutMs);
+    return true;
+}
+
+int ReplaySerialTransport::bytesAvailable()
+{
+    return getBytesDue();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "SerialTransport.h"
+
+/**
+ * Plays a file of raw serial bytes back as if a device were sending them,
+ * paced at the nominal line rate (10 bits per byte). Writes are accepted
+ * and discarded. Once the file is exhausted the transport just goes quiet.
+ */
+class ReplaySerialTransport : public SerialTransport
+{
+public:
+    // Open "file:/path/to/capture.bin"
+    static std::unique_ptr<ReplaySerialTransport> open(const juce::String& url, const Options& options);
+    
+    int read(juce::uint8* buffer, int maxBytes) override;
+    int write(const juce::uint8* data, int numBytes) override;
+    int waitForData(int timeoutMs) override;
+    void wake() override;
+    bool waitForWritable(int timeoutMs) override;
+    int bytesAvailable() override;
+    int getBaudRate() const override { return baudRate; }
+    
+private:
+    ReplaySerialTransport(std::unique_ptr<juce::FileInputStream> stream, int nominalBaud);
+    
+    // Bytes the line would have delivered by now and that haven't been read
+    int getBytesDue() const;
+    
+    std::unique_ptr<juce::FileInputStream> stream;
+    juce::WaitableEvent wakeEvent;
+    double startTimeMs;
+    juce::int64 bytesDelivered = 0;
+    int baudRate;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReplaySerialTransport)
+};
@@ -1,4 +1,7 @@
 #include "SerialPortManager.h"
+#include "SerialPortRegistry.h"
+#include "TrafficCapture.h"
+#include <algorithm>
 
 #if JUCE_WINDOWS
     #include <windows.h>
@@ -13,18 +16,85 @@
     #include <dirent.h>
     #include <sys/types.h>
     #include <sys/stat.h>
-    #include <fcntl.h>
-    #include <termios.h>
-    #include <unistd.h>
+    #include <limits.h>
+    #include <stdlib.h>
 #endif
 
+// How long closePort() lets the writer finish sending the queue
+static constexpr int closeDrainTimeoutMs = 250;
+
+//==============================================================================
+// Waits on the transport and notifies the owner as soon as data arrives
+class SerialPortManager::ReaderThread : public juce::Thread
+{
+public:
+    explicit ReaderThread(SerialPortManager& o)
+        : juce::Thread("Serial Reader"), owner(o)
+    {
+    }
+    
+    void run() override
+    {
+        owner.applyRealtimeOptions(getThreadName());
+        
+        while (! threadShouldExit())
+        {
+            const int result = owner.transport->waitForData(100);
+            
+            if (threadShouldExit())
+                break;
+            
+            const int added = result > 0 ? owner.fillRxRing() : 0;
+            
+            if (added > 0)
+            {
+                if (owner.onDataAvailable)
+                    owner.onDataAvailable();
+            }
+            else if (result < 0 || added < 0)
+            {
+                // Port error (e.g. device unplugged): report once, back off instead of spinning
+                owner.reportError(result < 0 ? "Serial port error" : "Serial read failed");
+                wait(100);
+            }
+        }
+    }
+    
+private:
+    SerialPortManager& owner;
+};
+
+//==============================================================================
+// Drains the transmit queue so callers never block on the port
+class SerialPortManager::WriterThread : public juce::Thread
+{
+public:
+    explicit WriterThread(SerialPortManager& o)
+        : juce::Thread("Serial Writer"), owner(o)
+    {
+    }
+    
+    void run() override
+    {
+        owner.applyRealtimeOptions(getThreadName());
+        
+        while (! threadShouldExit())
+        {
+            if (owner.txFifo.getNumReady() == 0 && owner.urgentFifo.getNumReady() == 0)
+                owner.txPending.wait(100);
+            else
+                owner.drainTxQueue();
+        }
+    }
+    
+private:
+    SerialPortManager& owner;
+};
+
+//==============================================================================
 SerialPortManager::SerialPortManager()
-    : portHandle(nullptr)
-#if JUCE_WINDOWS
-    , overlappedRead(nullptr)
-    , overlappedWrite(nullptr)
-#endif
 {
+    txBuffer.malloc(static_cast<size_t>(txQueueSize));
 }
 
 SerialPortManager::~SerialPortManager()
@@ -33,6 +103,46 @@ SerialPortManager::~SerialPortManager()
 }
 
 juce::Array<SerialPortManager::PortInfo> SerialPortManager::getAvailablePorts()
+{
+    return SerialPortRegistry::getInstance()->getPorts();
+}
+
+#if JUCE_LINUX
+static juce::String readSysfsAttribute(const juce::File& file)
+{
+    return file.existsAsFile() ? file.loadFileAsString().trim() : juce::String();
+}
+
+// Map /dev/ttyXXX -> /dev/serial/by-id/... (names that survive re-enumeration)
+static juce::HashMap<juce::String, juce::String> readSerialByIdLinks()
+{
+    juce::HashMap<juce::String, juce::String> links;
+    DIR* dir = opendir("/dev/serial/by-id");
+    
+    if (dir != nullptr)
+    {
+        struct dirent* entry;
+        
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            if (entry->d_name[0] == '.')
+                continue;
+            
+            juce::String linkPath = juce::String("/dev/serial/by-id/") + entry->d_name;
+            char target[PATH_MAX];
+            
+            if (realpath(linkPath.toRawUTF8(), target) != nullptr)
+                links.set(juce::String(target), linkPath);
+        }
+        
+        closedir(dir);
+    }
+    
+    return links;
+}
+#endif
+
+juce::Array<SerialPortManager::PortInfo> SerialPortManager::scanPorts()
 {
     juce::Array<PortInfo> ports;
     
@@ -121,9 +231,10 @@ juce::Array<SerialPortManager::PortInfo> SerialPortManager::getAvailablePorts()
     }
     
 #elif JUCE_LINUX
-    // Linux: Scan /dev for ttyUSB*, ttyACM*, ttyS* devices
-    const char* devDir = "/dev";
-    DIR* dir = opendir(devDir);
+    // Linux: walk /sys/class/tty and keep ports backed by a real device
+    // (ttyUSB*, ttyACM*, ttyS*), with USB identity read from sysfs
+    juce::HashMap<juce::String, juce::String> byIdLinks = readSerialByIdLinks();
+    DIR* dir = opendir("/sys/class/tty");
     
     if (dir != nullptr)
     {
@@ -133,17 +244,53 @@ juce::Array<SerialPortManager::PortInfo> SerialPortManager::getAvailablePorts()
         {
             juce::String name(entry->d_name);
             
-            if (name.startsWith("ttyUSB") || name.startsWith("ttyACM") || name.startsWith("ttyS"))
+            if (!(name.startsWith("ttyUSB") || name.startsWith("ttyACM") || name.startsWith("ttyS")))
+                continue;
+            
+            juce::String sysPath = "/sys/class/tty/" + name + "/device";
+            char resolved[PATH_MAX];
+            
+            if (realpath(sysPath.toRawUTF8(), resolved) == nullptr)
+                continue; // virtual tty, no hardware behind it
+            
+            PortInfo info;
+            info.portName = "/dev/" + name;
+            info.friendlyName = name;
+            
+            char driverPath[PATH_MAX];
+            if (realpath((sysPath + "/driver").toRawUTF8(), driverPath) != nullptr)
+                info.driver = juce::File(juce::String(driverPath)).getFileName();
+            
+            // The USB device is an ancestor of the tty's interface directory
+            for (juce::File usbDevice(juce::String{ resolved });
+                 usbDevice.getFullPathName().startsWith("/sys/devices/");
+                 usbDevice = usbDevice.getParentDirectory())
             {
-                PortInfo info;
-                info.portName = juce::String("/dev/") + name;
-                info.friendlyName = name;
-                ports.add(info);
+                if (usbDevice.getChildFile("idVendor").existsAsFile())
+                {
+                    info.vendorId = readSysfsAttribute(usbDevice.getChildFile("idVendor")).getHexValue32();
+                    info.productId = readSysfsAttribute(usbDevice.getChildFile("idProduct")).getHexValue32();
+                    info.serialNumber = readSysfsAttribute(usbDevice.getChildFile("serial"));
+                    info.description = readSysfsAttribute(usbDevice.getChildFile("product"));
+                    break;
+                }
             }
+            
+            if (info.description.isNotEmpty())
+                info.friendlyName = name + " - " + info.description;
+            
+            info.stableId = byIdLinks[info.portName];
+            ports.add(info);
         }
         
         closedir(dir);
     }
+    
+    // readdir order is arbitrary; keep the list stable for the UI
+    std::sort(ports.begin(), ports.end(), [](const PortInfo& a, const PortInfo& b)
+    {
+        return a.portName.compareNatural(b.portName) < 0;
+    });
 #endif
     
     return ports;
@@ -153,106 +300,132 @@ bool SerialPortManager::openPort(const juce::String& portName, int baudRate)
 {
     closePort();
     
-#if JUCE_WINDOWS
-    juce::String portPath = "\\\\.\\" + portName;
-    
-    HANDLE handle = CreateFileA(portPath.toRawUTF8(),
-                                 GENERIC_READ | GENERIC_WRITE,
-                                 0,
-                                 0,
-                                 OPEN_EXISTING,
-                                 FILE_FLAG_OVERLAPPED,
-                                 0);
-    
-    if (handle == INVALID_HANDLE_VALUE)
-        return false;
-    
-    DCB dcb;
-    memset(&dcb, 0, sizeof(DCB));
-    dcb.DCBlength = sizeof(DCB);
-    
-    if (!GetCommState(handle, &dcb))
-    {
-        CloseHandle(handle);
-        return false;
-    }
-    
-    dcb.BaudRate = baudRate;
-    dcb.ByteSize = 8;
-    dcb.Parity = NOPARITY;
-    dcb.StopBits = ONESTOPBIT;
+    auto newTransport = createTransport(portName, baudRate);
     
-    if (!SetCommState(handle, &dcb))
-    {
-        CloseHandle(handle);
+    if (newTransport == nullptr)
         return false;
-    }
     
-    COMMTIMEOUTS timeouts;
-    timeouts.ReadIntervalTimeout = MAXDWORD;
-    timeouts.ReadTotalTimeoutMultiplier = 0;
-    timeouts.ReadTotalTimeoutConstant = 0;
-    timeouts.WriteTotalTimeoutMultiplier = 0;
-    timeouts.WriteTotalTimeoutConstant = 0;
-    SetCommTimeouts(handle, &timeouts);
+    return openTransport(std::move(newTransport), portName);
+}
+
+std::unique_ptr<SerialTransport> SerialPortManager::createTransport(const juce::String& portName, int baudRate) const
+{
+    if (baudRate <= 0)
+        return nullptr;
     
-    portHandle = handle;
+    SerialTransport::Options options;
+    options.baudRate = baudRate;
+    options.lowLatency = lowLatencyMode;
+    options.latencyTimerMs = requestedLatencyTimerMs;
     
-#elif JUCE_MAC || JUCE_LINUX
-    int fd = open(portName.toRawUTF8(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    return SerialTransport::create(portName, options);
+}
+
+bool SerialPortManager::openTransport(std::unique_ptr<SerialTransport> newTransport, const juce::String& portName)
+{
+    closePort();
     
-    if (fd == -1)
+    if (newTransport == nullptr)
         return false;
     
-    struct termios options;
-    tcgetattr(fd, &options);
+    transport = std::move(newTransport);
     
-    // Set baud rate
-    speed_t speed = B115200;
-    switch (baudRate)
+    currentPortName = portName;
+    currentBaudRate = transport->getBaudRate();
+    lowLatencyStatus = transport->getLowLatencyStatus();
+    failed = false;
+    
+    // Fresh receive ring and transmit queue for this session
+    rxFifo.setTotalSize(rxBufferSize);
+    rxFifo.reset();
+    rxBuffer.malloc(static_cast<size_t>(rxBufferSize));
+    
+    rxMarkFifo.reset();
+    rxWritePosition = 0;
+    rxReadPosition = 0;
+    lastRxMark = RxMark();
+    lastRxMark.timeMs = juce::Time::getMillisecondCounterHiRes();
+    byteDurationMs = currentBaudRate > 0 ? 10000.0 / currentBaudRate : 0.0;
+    
+    // The transmit rings are already empty: closePort drained or dropped
+    // them with the producers shut out
+    
+    if (realtimeOptions.lockMemory)
     {
-        case 9600: speed = B9600; break;
-        case 19200: speed = B19200; break;
-        case 38400: speed = B38400; break;
-        case 57600: speed = B57600; break;
-        case 115200: speed = B115200; break;
+        RealtimeThreading::prefault(rxBuffer, static_cast<size_t>(rxBufferSize));
+        RealtimeThreading::prefault(txBuffer, static_cast<size_t>(txQueueSize));
     }
     
-    cfsetispeed(&options, speed);
-    cfsetospeed(&options, speed);
-    
-    // 8N1
-    options.c_cflag &= ~PARENB;
-    options.c_cflag &= ~CSTOPB;
-    options.c_cflag &= ~CSIZE;
-    options.c_cflag |= CS8;
+    writerThread = std::make_unique<WriterThread>(*this);
+    writerThread->startThread(juce::Thread::Priority::high);
     
-    // Raw input
-    options.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
-    options.c_oflag &= ~OPOST;
+    // Everything is in place: let producers in
+    sessionOpen = true;
+    return true;
+}
+
+void SerialPortManager::applyRealtimeOptions(const juce::String& threadName)
+{
+    if (realtimeOptions.isDefault())
+        return;
     
-    tcsetattr(fd, TCSANOW, &options);
+    auto report = RealtimeThreading::applyToCurrentThread(threadName, realtimeOptions);
     
-    portHandle = reinterpret_cast<void*>(static_cast<intptr_t>(fd));
-#endif
+    if (onThreadScheduling)
+        onThreadScheduling(report);
+}
+
+void SerialPortManager::setLowLatencyMode(bool enabled, int latencyTimerMs)
+{
+    lowLatencyMode = enabled;
+    requestedLatencyTimerMs = juce::jlimit(1, 255, latencyTimerMs);
+}
+
+void SerialPortManager::closeSession()
+{
+    sessionOpen = false;
     
-    currentPortName = portName;
-    return true;
+    // A producer that got in before the flag dropped is still using the
+    // rings and the writer; one that comes later sees the flag and leaves
+    while (txProducers.load() > 0)
+        juce::Thread::yield();
 }
 
 void SerialPortManager::closePort()
 {
-    if (portHandle != nullptr)
+    closeSession();
+    stopReading();
+    
+    if (writerThread != nullptr)
     {
-#if JUCE_WINDOWS
-        CloseHandle(static_cast<HANDLE>(portHandle));
-#else
-        close(static_cast<int>(reinterpret_cast<intptr_t>(portHandle)));
-#endif
-        portHandle = nullptr;
+        // Let the writer send what is already queued (the note-offs a detach
+        // releases, say), but don't hang on a port that stopped taking data
+        const auto deadline = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(closeDrainTimeoutMs);
+        txPending.signal();
+        
+        while ((txFifo.getNumReady() > 0 || urgentFifo.getNumReady() > 0)
+                && juce::Time::getMillisecondCounter() < deadline)
+            juce::Thread::sleep(1);
+        
+        writerThread->signalThreadShouldExit();
+        txPending.signal();
+        writerThread->stopThread(2000);
+        writerThread.reset();
+    }
+    
+    // Anything still queued never made it to the port
+    const int unsent = txFifo.getNumReady() + urgentFifo.getNumReady();
+    if (unsent > 0)
+    {
+        txBytesDropped += static_cast<juce::uint64>(unsent);
+        txFifo.reset();
+        urgentFifo.reset();
     }
     
+    transport.reset();
+    
     currentPortName = juce::String();
+    currentBaudRate = 0;
 }
 
 int SerialPortManager::write(const juce::uint8* data, int numBytes)
@@ -260,65 +433,272 @@ int SerialPortManager::write(const juce::uint8* data, int numBytes)
     if (!isOpen())
         return 0;
     
-#if JUCE_WINDOWS
-    DWORD bytesWritten = 0;
-    OVERLAPPED overlapped = {0};
-    overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    return transport->write(data, numBytes);
+}
+
+int SerialPortManager::fillRxRing()
+{
+    const int freeSpace = rxFifo.getFreeSpace();
+    
+    if (freeSpace == 0)
+    {
+        // Consumer is behind: leave the bytes in the driver until it catches up
+        rxSpaceAvailable.wait(5);
+        return 0;
+    }
     
-    if (WriteFile(static_cast<HANDLE>(portHandle), data, numBytes, &bytesWritten, &overlapped))
+    int start1, size1, start2, size2;
+    rxFifo.prepareToWrite(freeSpace, start1, size1, start2, size2);
+    
+    const int firstRead = transport->read(rxBuffer + start1, size1);
+    
+    if (firstRead < 0)
+        return -1;
+    
+    int total = firstRead;
+    
+    if (total == size1 && size2 > 0)
+        total += juce::jmax(0, transport->read(rxBuffer + start2, size2));
+    
+    if (total > 0)
     {
-        CloseHandle(overlapped.hEvent);
-        return bytesWritten;
+        const double now = juce::Time::getMillisecondCounterHiRes();
+        rxWritePosition += static_cast<juce::uint64>(total);
+        
+        // The mark goes in before the bytes are published, so the consumer
+        // always finds one. If the consumer is that far behind, the bytes
+        // are stamped when they are looked up instead.
+        if (rxMarkFifo.getFreeSpace() > 0)
+        {
+            int markStart1, markSize1, markStart2, markSize2;
+            rxMarkFifo.prepareToWrite(1, markStart1, markSize1, markStart2, markSize2);
+            rxMarks[markStart1] = { rxWritePosition, now };
+            rxMarkFifo.finishedWrite(1);
+        }
+        
+        if (capture != nullptr)
+        {
+            capture->write(TrafficCapture::Source::serial, TrafficCapture::Direction::in, now,
+                           rxBuffer + start1, juce::jmin(total, size1));
+            
+            if (total > size1)
+                capture->write(TrafficCapture::Source::serial, TrafficCapture::Direction::in, now,
+                               rxBuffer + start2, total - size1);
+        }
+        
+        rxFifo.finishedWrite(total);
+        rxBytesReceived += static_cast<juce::uint64>(total);
+        
+        const int ready = rxFifo.getNumReady();
+        if (ready > rxHighWaterMark.load(std::memory_order_relaxed))
+            rxHighWaterMark.store(ready, std::memory_order_relaxed);
     }
     
-    if (GetLastError() == ERROR_IO_PENDING)
+    return total;
+}
+
+SerialPortManager::RxSpans SerialPortManager::getReceivedData() const
+{
+    RxSpans spans;
+    int start1, size1, start2, size2;
+    rxFifo.prepareToRead(rxFifo.getNumReady(), start1, size1, start2, size2);
+    
+    spans.data1 = rxBuffer + start1;
+    spans.size1 = size1;
+    spans.data2 = rxBuffer + start2;
+    spans.size2 = size2;
+    spans.position = rxReadPosition;
+    return spans;
+}
+
+void SerialPortManager::finishedReading(int numBytes)
+{
+    rxReadPosition += static_cast<juce::uint64>(numBytes);
+    rxFifo.finishedRead(numBytes);
+    rxSpaceAvailable.signal();
+}
+
+double SerialPortManager::getArrivalTime(juce::uint64 position)
+{
+    for (;;)
     {
-        if (GetOverlappedResult(static_cast<HANDLE>(portHandle), &overlapped, &bytesWritten, TRUE))
+        int start1, size1, start2, size2;
+        rxMarkFifo.prepareToRead(1, start1, size1, start2, size2);
+        
+        if (size1 == 0)
+            return juce::jmax(lastRxMark.timeMs, juce::Time::getMillisecondCounterHiRes());
+        
+        const RxMark& mark = rxMarks[start1];
+        
+        if (position < mark.endPosition)
         {
-            CloseHandle(overlapped.hEvent);
-            return bytesWritten;
+            // The last byte of the read had just arrived when it returned
+            const double estimate = mark.timeMs - static_cast<double>(mark.endPosition - 1 - position) * byteDurationMs;
+            return juce::jmax(lastRxMark.timeMs, estimate);
         }
+        
+        lastRxMark = mark;
+        rxMarkFifo.finishedRead(1);
+    }
+}
+
+SerialPortManager::RxStats SerialPortManager::getRxStats() const
+{
+    RxStats stats;
+    stats.bytesReceived = rxBytesReceived.load();
+    stats.highWaterMark = rxHighWaterMark.load();
+    stats.capacity = rxFifo.getTotalSize() - 1;    // AbstractFifo keeps one slot free
+    return stats;
+}
+
+void SerialPortManager::resetRxStats()
+{
+    rxBytesReceived = 0;
+    rxHighWaterMark = 0;
+}
+
+bool SerialPortManager::queueWrite(const juce::uint8* data, int numBytes)
+{
+    if (numBytes <= 0)
+        return true;
+    
+    // Lock-free: the counter keeps closePort from tearing the session down under us
+    ++txProducers;
+    
+    if (! sessionOpen.load() || txFifo.getFreeSpace() < numBytes)
+    {
+        --txProducers;
+        
+        // Never split a chunk: a partial MIDI message is worse than none
+        txBytesDropped += static_cast<juce::uint64>(numBytes);
+        return false;
     }
     
-    CloseHandle(overlapped.hEvent);
-    return 0;
+    int start1, size1, start2, size2;
+    txFifo.prepareToWrite(numBytes, start1, size1, start2, size2);
     
-#else
-    return ::write(static_cast<int>(reinterpret_cast<intptr_t>(portHandle)), data, numBytes);
-#endif
+    memcpy(txBuffer + start1, data, static_cast<size_t>(size1));
+    if (size2 > 0)
+        memcpy(txBuffer + start2, data + size1, static_cast<size_t>(size2));
+    
+    txFifo.finishedWrite(size1 + size2);
+    txBytesQueued += static_cast<juce::uint64>(numBytes);
+    txPending.signal();
+    
+    --txProducers;
+    return true;
 }
 
-int SerialPortManager::read(juce::uint8* buffer, int maxBytes)
+bool SerialPortManager::queueRealtimeByte(juce::uint8 byte)
 {
-    if (!isOpen())
-        return 0;
+    ++txProducers;
     
-#if JUCE_WINDOWS
-    DWORD bytesRead = 0;
-    OVERLAPPED overlapped = {0};
-    overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (! sessionOpen.load() || urgentFifo.getFreeSpace() < 1)
+    {
+        --txProducers;
+        txBytesDropped += 1;
+        return false;
+    }
     
-    if (ReadFile(static_cast<HANDLE>(portHandle), buffer, maxBytes, &bytesRead, &overlapped))
+    int start1, size1, start2, size2;
+    urgentFifo.prepareToWrite(1, start1, size1, start2, size2);
+    urgentBuffer[start1] = byte;
+    urgentFifo.finishedWrite(1);
+    
+    txRealtimeBytesQueued += 1;
+    txPending.signal();
+    
+    --txProducers;
+    return true;
+}
+
+void SerialPortManager::drainTxQueue()
+{
+    // Small chunks, so a real-time byte never waits behind a whole SysEx dump
+    while (txFifo.getNumReady() > 0 || urgentFifo.getNumReady() > 0)
     {
-        CloseHandle(overlapped.hEvent);
-        return bytesRead;
+        if (! writeFromFifo(urgentFifo, urgentBuffer, urgentQueueSize))
+            return;
+        
+        if (! writeFromFifo(txFifo, txBuffer, txChunkSize))
+            return;
     }
+}
+
+bool SerialPortManager::writeFromFifo(juce::AbstractFifo& fifo, const juce::uint8* buffer, int maxBytes)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(juce::jmin(maxBytes, fifo.getNumReady()), start1, size1, start2, size2);
     
-    if (GetLastError() == ERROR_IO_PENDING)
+    const int starts[] = { start1, start2 };
+    const int sizes[] = { size1, size2 };
+    
+    for (int block = 0; block < 2; ++block)
     {
-        if (GetOverlappedResult(static_cast<HANDLE>(portHandle), &overlapped, &bytesRead, TRUE))
+        int offset = 0;
+        
+        while (offset < sizes[block])
         {
-            CloseHandle(overlapped.hEvent);
-            return bytesRead;
+            if (juce::Thread::currentThreadShouldExit())
+                return false;
+            
+            // The transport directly: isOpen() is already false while
+            // closePort waits for this thread
+            int written = transport->write(buffer + starts[block] + offset, sizes[block] - offset);
+            
+            if (written > 0)
+            {
+                if (capture != nullptr)
+                    capture->write(TrafficCapture::Source::serial, TrafficCapture::Direction::out,
+                                   juce::Time::getMillisecondCounterHiRes(),
+                                   buffer + starts[block] + offset, written);
+                
+                offset += written;
+                fifo.finishedRead(written);
+                txBytesWritten += static_cast<juce::uint64>(written);
+            }
+            else if (written < 0)
+            {
+                // Hard error: leave the bytes queued for closePort to account for
+                reportError("Serial write failed");
+                juce::Thread::sleep(50);
+                return false;
+            }
+            else
+            {
+                // Driver buffer full: wait and retry
+                transport->waitForWritable(50);
+            }
         }
     }
     
-    CloseHandle(overlapped.hEvent);
-    return 0;
+    return true;
+}
+
+SerialPortManager::TxStats SerialPortManager::getTxStats() const
+{
+    TxStats stats;
+    stats.bytesQueued = txBytesQueued.load();
+    stats.bytesWritten = txBytesWritten.load();
+    stats.bytesDropped = txBytesDropped.load();
+    stats.realtimeBytesQueued = txRealtimeBytesQueued.load();
+    return stats;
+}
+
+void SerialPortManager::resetTxStats()
+{
+    txBytesQueued = 0;
+    txBytesWritten = 0;
+    txBytesDropped = 0;
+    txRealtimeBytesQueued = 0;
+}
+
+int SerialPortManager::read(juce::uint8* buffer, int maxBytes)
+{
+    if (!isOpen())
+        return 0;
     
-#else
-    return ::read(static_cast<int>(reinterpret_cast<intptr_t>(portHandle)), buffer, maxBytes);
-#endif
+    return transport->read(buffer, maxBytes);
 }
 
 int SerialPortManager::bytesAvailable() const
@@ -326,18 +706,40 @@ int SerialPortManager::bytesAvailable() const
     if (!isOpen())
         return 0;
     
-#if JUCE_WINDOWS
-    COMSTAT comStat;
-    DWORD errors;
+    return transport->bytesAvailable();
+}
+
+void SerialPortManager::reportError(const juce::String& message)
+{
+    if (! failed.exchange(true) && onError)
+        onError(message);
+}
+
+bool SerialPortManager::startReading()
+{
+    if (!isOpen())
+        return false;
     
-    if (ClearCommError(static_cast<HANDLE>(portHandle), &errors, &comStat))
-        return comStat.cbInQue;
+    if (readerThread == nullptr)
+        readerThread = std::make_unique<ReaderThread>(*this);
     
-    return 0;
+    if (readerThread->isThreadRunning())
+        return true;
     
-#else
-    int bytes = 0;
-    ioctl(static_cast<int>(reinterpret_cast<intptr_t>(portHandle)), FIONREAD, &bytes);
-    return bytes;
-#endif
+    return readerThread->startThread(juce::Thread::Priority::high);
+}
+
+void SerialPortManager::stopReading()
+{
+    if (readerThread == nullptr)
+        return;
+    
+    readerThread->signalThreadShouldExit();
+    
+    if (transport != nullptr)
+        transport->wake();
+    
+    readerThread->notify();
+    readerThread->stopThread(2000);
+    readerThread.reset();
 }
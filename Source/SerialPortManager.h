@@ -1,10 +1,17 @@
 #pragma once
 
 #include <juce_core/juce_core.h>
+#include "SerialTransport.h"
+#include "RealtimeThreading.h"
+
+class TrafficCapture;
 
 /**
  * SerialPortManager handles serial port enumeration and communication
  * This replaces the qextserialport functionality from the Qt version
+ *
+ * The bytes themselves go through a SerialTransport, so the same reader,
+ * writer and ring buffers work over a device, a pty, TCP or a replay file.
  */
 class SerialPortManager
 {
@@ -15,47 +22,261 @@ public:
         juce::String friendlyName;
         juce::String description;
         
+        // Device identity (filled in where the platform exposes it)
+        int vendorId = 0;
+        int productId = 0;
+        juce::String serialNumber;
+        juce::String driver;
+        juce::String stableId;     // e.g. /dev/serial/by-id/usb-Arduino_..., survives re-enumeration
+        
         juce::String getDisplayName() const
         {
             return friendlyName.isEmpty() ? portName : friendlyName;
         }
     };
     
+    // Byte counters for the transmit queue
+    struct TxStats
+    {
+        juce::uint64 bytesQueued = 0;
+        juce::uint64 bytesWritten = 0;
+        juce::uint64 bytesDropped = 0;
+        juce::uint64 realtimeBytesQueued = 0;   // via queueRealtimeByte()
+    };
+    
+    // Counters for the receive ring
+    struct RxStats
+    {
+        juce::uint64 bytesReceived = 0;
+        int highWaterMark = 0;   // most bytes ever waiting in the ring
+        int capacity = 0;        // bytes the ring can actually hold
+    };
+    
+    // Up to two contiguous runs of received bytes (the ring may wrap)
+    struct RxSpans
+    {
+        const juce::uint8* data1 = nullptr;
+        int size1 = 0;
+        const juce::uint8* data2 = nullptr;
+        int size2 = 0;
+        juce::uint64 position = 0;   // stream offset of data1[0] since the port opened
+        
+        int getTotalSize() const { return size1 + size2; }
+    };
+    
+    using LowLatencyStatus = SerialTransport::LowLatencyStatus;
+    
     SerialPortManager();
     ~SerialPortManager();
     
-    // Get list of available serial ports
+    // Get list of available serial ports (cached by SerialPortRegistry)
     static juce::Array<PortInfo> getAvailablePorts();
     
-    // Open a serial port
+    // Enumerate the ports on the system right now (slow; prefer the registry)
+    static juce::Array<PortInfo> scanPorts();
+    
+    // Open a serial port. Any positive baud rate is accepted; rates without
+    // a standard constant (e.g. 31250, 250000, 2000000) use the platform's
+    // custom-rate mechanism (termios2/BOTHER on Linux, IOSSIOSPEED on macOS).
+    // Fails rather than silently falling back if the driver refuses the rate.
+    // "pty:", "tcp://host:port" and "file:/path" open the virtual backends
+    // described in SerialTransport.h.
     bool openPort(const juce::String& portName, int baudRate = 115200);
     
-    // Close the current port
+    // The first half of openPort: open the transport with the current
+    // settings, leaving any open session alone. May block (a tcp:// connect
+    // takes up to a second), so call it without holding locks the session
+    // needs, then hand the result to openTransport.
+    std::unique_ptr<SerialTransport> createTransport(const juce::String& portName, int baudRate) const;
+    
+    // Run a session over a transport opened elsewhere (e.g. a custom backend)
+    bool openTransport(std::unique_ptr<SerialTransport> newTransport, const juce::String& portName);
+    
+    // Port name that opens a pseudo-terminal loopback instead of a device
+    // (POSIX only). The manager owns the master side; point a device
+    // simulator at getPseudoTerminalPath() to feed it synthetic traffic.
+    static constexpr const char* pseudoTerminalPortName = SerialTransport::pseudoTerminalPortName;
+    
+    // Slave device path (e.g. /dev/pts/5) while a pty loopback is open
+    juce::String getPseudoTerminalPath() const { return transport != nullptr ? transport->getPeerPath() : juce::String(); }
+    
+    // Baud rate the driver actually applied (0 when closed)
+    int getBaudRate() const { return currentBaudRate; }
+    
+    // Low-latency open mode (takes effect on the next openPort): sets
+    // VMIN/VTIME to 0, the ASYNC_LOW_LATENCY flag and the USB-serial
+    // latency timer (default 16 ms on FTDI chips) to latencyTimerMs
+    void setLowLatencyMode(bool enabled, int latencyTimerMs = 1);
+    bool getLowLatencyMode() const { return lowLatencyMode; }
+    
+    // What was actually applied by the last openPort
+    LowLatencyStatus getLowLatencyStatus() const { return lowLatencyStatus; }
+    
+    // Close the current port. Queued writes get a short while to go out first.
     void closePort();
     
-    // Check if port is open
-    bool isOpen() const { return portHandle != nullptr; }
+    // Check if port is open (safe from any thread)
+    bool isOpen() const { return sessionOpen.load(); }
     
-    // Write data to serial port
+    // Write data to serial port (direct, may write less than numBytes)
     int write(const juce::uint8* data, int numBytes);
     
+    // Queue data for the writer thread. Never blocks: if the whole chunk
+    // doesn't fit, or no port is open, it is dropped and counted. Single
+    // producer only, but it may race with openPort/closePort on another
+    // thread: closePort waits for it to leave before tearing anything down.
+    bool queueWrite(const juce::uint8* data, int numBytes);
+    
+    // Queue a MIDI real-time byte (clock, start/stop, active sensing) on a
+    // separate lane that the writer thread services ahead of the normal
+    // queue, between chunks of any message already in flight. MIDI allows
+    // real-time bytes anywhere in the stream. Same producer as queueWrite.
+    bool queueRealtimeByte(juce::uint8 byte);
+    
+    TxStats getTxStats() const;
+    void resetTxStats();
+    
     // Read available data from serial port
     int read(juce::uint8* buffer, int maxBytes);
     
     // Check if data is available
     int bytesAvailable() const;
     
-    // Set a callback for when data arrives
+    // Start a background thread that blocks on the port, copies incoming
+    // bytes into the receive ring and fires onDataAvailable
+    bool startReading();
+    
+    // Stop the reader thread (also done by closePort)
+    void stopReading();
+    
+    // Set a callback for when new bytes are in the receive ring.
+    // Called on the reader thread, not the message thread: keep it short.
     std::function<void()> onDataAvailable;
     
+    // Called once per session when a read or write fails in a way that
+    // means the device is gone (unplugged, reset, hangup). Called on the
+    // reader or writer thread; don't close the port from inside it.
+    std::function<void(const juce::String&)> onError;
+    
+    // True once an I/O error has been reported for the current session
+    bool hasFailed() const { return failed.load(); }
+    
+    // Name the port was opened with
+    const juce::String& getPortName() const { return currentPortName; }
+    
+    // Receive ring consumer side (single consumer). Returns everything
+    // currently buffered; call finishedReading() with the bytes consumed.
+    RxSpans getReceivedData() const;
+    void finishedReading(int numBytes);
+    
+    // When the byte at a stream offset came off the wire, in
+    // Time::getMillisecondCounterHiRes() milliseconds. Every read is stamped
+    // as it returns; bytes before the last one in a read are placed one
+    // character time (10 bits at the baud rate) apart, but never before the
+    // previous read. Consumer side: offsets must not go backwards, and must
+    // not be behind data already passed to finishedReading().
+    double getArrivalTime(juce::uint64 position);
+    
+    // Receive ring capacity in bytes (takes effect on the next openPort)
+    void setRxBufferSize(int numBytes) { rxBufferSize = juce::jmax(64, numBytes); }
+    
+    RxStats getRxStats() const;
+    void resetRxStats();
+    
+    // Scheduling for the reader and writer threads (takes effect when they
+    // next start). With lockMemory the rings are prefaulted on open.
+    void setRealtimeOptions(const RealtimeOptions& options) { realtimeOptions = options; }
+    
+    // Called on the reader/writer thread with what it actually got
+    std::function<void(const RealtimeThreading::Report&)> onThreadScheduling;
+    
+    // Record every read and write as it completes (set while the port is
+    // closed; the capture must outlive the port)
+    void setTrafficCapture(TrafficCapture* newCapture) { capture = newCapture; }
+    
 private:
-    void* portHandle;
+    class ReaderThread;
+    class WriterThread;
+    
+    // Flag the session as failed and fire onError (first time only)
+    void reportError(const juce::String& message);
+    
+    // Called by each I/O thread as it starts
+    void applyRealtimeOptions(const juce::String& threadName);
+    
+    // Called on the reader thread: move bytes from the driver into the ring.
+    // Returns the number of bytes added, or -1 if the port has failed.
+    int fillRxRing();
+    
+    // Called on the writer thread: push queued bytes out, retrying short writes
+    void drainTxQueue();
+    
+    // Write up to maxBytes from one of the transmit FIFOs. Returns false if
+    // the port failed or the thread was asked to exit.
+    bool writeFromFifo(juce::AbstractFifo& fifo, const juce::uint8* buffer, int maxBytes);
+    
+    // Close the producer gate and wait for queueWrite/queueRealtimeByte
+    // calls already inside to leave
+    void closeSession();
+    
+    std::unique_ptr<SerialTransport> transport;
     juce::String currentPortName;
+    int currentBaudRate = 0;
+    bool lowLatencyMode = false;
+    int requestedLatencyTimerMs = 1;
+    LowLatencyStatus lowLatencyStatus;
+    std::unique_ptr<ReaderThread> readerThread;
+    std::atomic<bool> failed { false };
+    std::unique_ptr<WriterThread> writerThread;
+    RealtimeOptions realtimeOptions;
+    TrafficCapture* capture = nullptr;
+    
+    // Receive ring (reader thread -> bridge)
+    int rxBufferSize = 65536;
+    juce::AbstractFifo rxFifo { 65536 };
+    juce::HeapBlock<juce::uint8> rxBuffer;
+    juce::WaitableEvent rxSpaceAvailable;
+    std::atomic<juce::uint64> rxBytesReceived { 0 };
+    std::atomic<int> rxHighWaterMark { 0 };
+    
+    // Receive timestamps: one mark per read, queued alongside the ring
+    struct RxMark
+    {
+        juce::uint64 endPosition = 0;   // stream offset just past the read
+        double timeMs = 0.0;
+    };
+    
+    static constexpr int rxMarkCount = 1024;
+    juce::AbstractFifo rxMarkFifo { rxMarkCount };
+    RxMark rxMarks[rxMarkCount];
+    juce::uint64 rxWritePosition = 0;   // reader thread
+    juce::uint64 rxReadPosition = 0;    // consumer
+    RxMark lastRxMark;                  // consumer: newest mark already passed
+    double byteDurationMs = 0.0;
+    
+    // Transmit queue (MIDI callback thread -> writer thread). Allocated once
+    // in the constructor: producers may still be running while a session
+    // is swapped, so the rings must never move.
+    static constexpr int txQueueSize = 8192;
+    juce::AbstractFifo txFifo { txQueueSize };
+    juce::HeapBlock<juce::uint8> txBuffer;
+    juce::WaitableEvent txPending;
+    std::atomic<juce::uint64> txBytesQueued { 0 };
+    std::atomic<juce::uint64> txBytesWritten { 0 };
+    std::atomic<juce::uint64> txBytesDropped { 0 };
+    
+    // Real-time lane, drained before each chunk of the normal queue
+    static constexpr int urgentQueueSize = 64;
+    static constexpr int txChunkSize = 128;
+    juce::AbstractFifo urgentFifo { urgentQueueSize };
+    juce::uint8 urgentBuffer[urgentQueueSize] = {};
+    std::atomic<juce::uint64> txRealtimeBytesQueued { 0 };
     
-#if JUCE_WINDOWS
-    void* overlappedRead;
-    void* overlappedWrite;
-#endif
+    // Producer gate: queueWrite/queueRealtimeByte only touch the rings and
+    // the writer thread while sessionOpen is set, and count themselves in
+    // txProducers so closePort can wait for them to leave
+    std::atomic<bool> sessionOpen { false };
+    std::atomic<int> txProducers { 0 };
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SerialPortManager)
 };
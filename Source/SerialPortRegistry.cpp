@@ -0,0 +1,201 @@
+#include "SerialPortRegistry.h"
+
+#if JUCE_LINUX
+    #include <sys/socket.h>
+    #include <linux/netlink.h>
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
+//==============================================================================
+// Listens for kernel tty uevents and rescans once things have settled
+class SerialPortRegistry::HotplugThread : public juce::Thread
+{
+public:
+    explicit HotplugThread(SerialPortRegistry& o)
+        : juce::Thread("Serial Hotplug"), owner(o)
+    {
+    }
+    
+    void run() override
+    {
+#if JUCE_LINUX
+        int sock = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+        
+        if (sock < 0)
+            return;
+        
+        struct sockaddr_nl address;
+        memset(&address, 0, sizeof(address));
+        address.nl_family = AF_NETLINK;
+        address.nl_pid = 0;
+        address.nl_groups = 1; // kernel uevents
+        
+        if (bind(sock, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            close(sock);
+            return;
+        }
+        
+        // udev creates the /dev node and by-id links after the kernel event,
+        // so wait for a quiet period before rescanning
+        constexpr juce::uint32 settleMs = 500;
+        bool pending = false;
+        juce::uint32 lastEventTime = 0;
+        char buffer[4096];
+        
+        while (! threadShouldExit())
+        {
+            struct pollfd fds;
+            fds.fd = sock;
+            fds.events = POLLIN;
+            fds.revents = 0;
+            
+            if (poll(&fds, 1, 100) > 0 && (fds.revents & POLLIN))
+            {
+                ssize_t length = recv(sock, buffer, sizeof(buffer) - 1, 0);
+                
+                if (length > 0 && isTtyEvent(buffer, static_cast<int>(length)))
+                {
+                    pending = true;
+                    lastEventTime = juce::Time::getMillisecondCounter();
+                }
+            }
+            
+            if (pending && juce::Time::getMillisecondCounter() - lastEventTime >= settleMs)
+            {
+                pending = false;
+                owner.refresh();
+            }
+        }
+        
+        close(sock);
+#endif
+    }
+    
+private:
+    // A uevent is "action@devpath\0KEY=value\0KEY=value..."
+    static bool isTtyEvent(const char* data, int length)
+    {
+        for (int i = 0; i < length; i += static_cast<int>(strnlen(data + i, static_cast<size_t>(length - i))) + 1)
+            if (strncmp(data + i, "SUBSYSTEM=tty", 14) == 0)
+                return true;
+        
+        return false;
+    }
+    
+    SerialPortRegistry& owner;
+};
+
+//==============================================================================
+JUCE_IMPLEMENT_SINGLETON(SerialPortRegistry)
+
+SerialPortRegistry::SerialPortRegistry() = default;
+
+SerialPortRegistry::~SerialPortRegistry()
+{
+    stopMonitoring();
+    clearSingletonInstance();
+}
+
+juce::Array<SerialPortRegistry::PortInfo> SerialPortRegistry::getPorts()
+{
+    {
+        const juce::ScopedLock sl(lock);
+        
+        if (scanned)
+            return ports;
+    }
+    
+    refresh();
+    
+    const juce::ScopedLock sl(lock);
+    return ports;
+}
+
+bool SerialPortRegistry::findByDisplayName(const juce::String& displayName, PortInfo& result)
+{
+    for (auto& port : getPorts())
+    {
+        if (port.getDisplayName() == displayName)
+        {
+            result = port;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+bool SerialPortRegistry::findByPortName(const juce::String& portName, PortInfo& result)
+{
+    for (auto& port : getPorts())
+    {
+        if (port.portName == portName || (port.stableId.isNotEmpty() && port.stableId == portName))
+        {
+            result = port;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+bool SerialPortRegistry::findByStableId(const juce::String& stableId, PortInfo& result)
+{
+    if (stableId.isEmpty())
+        return false;
+    
+    for (auto& port : getPorts())
+    {
+        if (port.stableId == stableId)
+        {
+            result = port;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+void SerialPortRegistry::refresh()
+{
+    auto scannedPorts = SerialPortManager::scanPorts();
+    bool changed = false;
+    
+    {
+        const juce::ScopedLock sl(lock);
+        
+        changed = ! scanned || scannedPorts.size() != ports.size();
+        
+        for (int i = 0; ! changed && i < ports.size(); ++i)
+            changed = ports.getReference(i).portName != scannedPorts.getReference(i).portName
+                   || ports.getReference(i).stableId != scannedPorts.getReference(i).stableId;
+        
+        ports = scannedPorts;
+        scanned = true;
+    }
+    
+    if (changed)
+        sendChangeMessage();
+}
+
+void SerialPortRegistry::startMonitoring()
+{
+#if JUCE_LINUX
+    if (hotplugThread != nullptr)
+        return;
+    
+    hotplugThread = std::make_unique<HotplugThread>(*this);
+    hotplugThread->startThread(juce::Thread::Priority::low);
+#endif
+}
+
+void SerialPortRegistry::stopMonitoring()
+{
+    if (hotplugThread != nullptr)
+    {
+        hotplugThread->stopThread(1000);
+        hotplugThread.reset();
+    }
+}
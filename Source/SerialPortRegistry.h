@@ -0,0 +1,54 @@
+#pragma once
+
+#include <juce_events/juce_events.h>
+#include "SerialPortManager.h"
+
+/**
+ * SerialPortRegistry keeps a cached list of serial ports so lookups don't
+ * rescan the system. On Linux it is filled from sysfs (USB VID/PID, serial
+ * number, driver, /dev/serial/by-id name) and kept up to date by a netlink
+ * uevent monitor; listeners get a change message on the message thread
+ * whenever ports appear or disappear. Other platforms rescan on refresh().
+ *
+ * A JUCE singleton deleted at shutdown, so the hotplug thread stops while
+ * the message manager still exists.
+ */
+class SerialPortRegistry : public juce::ChangeBroadcaster,
+                           private juce::DeletedAtShutdown
+{
+public:
+    using PortInfo = SerialPortManager::PortInfo;
+    
+    SerialPortRegistry();
+    ~SerialPortRegistry() override;
+    
+    JUCE_DECLARE_SINGLETON(SerialPortRegistry, false)
+    
+    // Cached port list (scanned on first use)
+    juce::Array<PortInfo> getPorts();
+    
+    // Lookups against the cached list; return false if nothing matches
+    bool findByDisplayName(const juce::String& displayName, PortInfo& result);
+    bool findByPortName(const juce::String& portName, PortInfo& result);
+    
+    // Find a port by the identity of the device behind it, so the same board
+    // is found again after it re-enumerates under a different tty name
+    bool findByStableId(const juce::String& stableId, PortInfo& result);
+    
+    // Rescan now and notify listeners if the list changed
+    void refresh();
+    
+    // Hotplug monitoring (Linux only; a no-op elsewhere)
+    void startMonitoring();
+    void stopMonitoring();
+    
+private:
+    class HotplugThread;
+    
+    juce::CriticalSection lock;
+    juce::Array<PortInfo> ports;
+    bool scanned { false };
+    std::unique_ptr<HotplugThread> hotplugThread;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SerialPortRegistry)
+};
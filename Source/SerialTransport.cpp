@@ -0,0 +1,32 @@
+#include "SerialTransport.h"
+#include "NativeSerialTransport.h"
+#include "PseudoTerminalTransport.h"
+#include "TcpSerialTransport.h"
+#include "ReplaySerialTransport.h"
+
+bool SerialTransport::isDevicePortName(const juce::String& portName)
+{
+    return portName != pseudoTerminalPortName
+        && ! portName.startsWithIgnoreCase(tcpPrefix)
+        && ! portName.startsWithIgnoreCase(replayPrefix);
+}
+
+std::unique_ptr<SerialTransport> SerialTransport::create(const juce::String& portName, const Options& options)
+{
+    if (portName == pseudoTerminalPortName)
+    {
+       #if JUCE_WINDOWS
+        return nullptr;
+       #else
+        return PseudoTerminalTransport::open(options);
+       #endif
+    }
+    
+    if (portName.startsWithIgnoreCase(tcpPrefix))
+        return TcpSerialTransport::open(portName, options);
+    
+    if (portName.startsWithIgnoreCase(replayPrefix))
+        return ReplaySerialTransport::open(portName, options);
+    
+    return NativeSerialTransport::open(portName, options);
+}
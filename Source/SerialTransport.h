@@ -0,0 +1,82 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/**
+ * SerialTransport is the byte pipe underneath SerialPortManager. Backends:
+ *
+ *   "COM3", "/dev/ttyUSB0"   NativeSerialTransport (Win32 / termios)
+ *   "pty:"                   PseudoTerminalTransport (POSIX loopback)
+ *   "tcp://host:port"        TcpSerialTransport (raw TCP, e.g. ser2net)
+ *   "file:/path/capture.bin" ReplaySerialTransport (plays a file back)
+ *
+ * A transport is open from construction until it is destroyed. read() and
+ * write() are non-blocking; waitForData() does the blocking and can be
+ * interrupted from another thread with wake().
+ */
+class SerialTransport
+{
+public:
+    // What SerialPortManager asks for when it opens a port
+    struct Options
+    {
+        int baudRate = 115200;
+        bool lowLatency = false;
+        int latencyTimerMs = 1;
+    };
+    
+    // Effective low-latency settings, read back from the driver after open.
+    // -1 means the setting isn't available for this port/platform.
+    struct LowLatencyStatus
+    {
+        bool requested = false;
+        bool asyncLowLatency = false;   // Linux serial_struct ASYNC_LOW_LATENCY flag
+        int vmin = -1;
+        int vtime = -1;                 // tenths of a second
+        int latencyTimerMs = -1;        // USB-serial (FTDI) latency timer
+    };
+    
+    static constexpr const char* pseudoTerminalPortName = "pty:";
+    static constexpr const char* tcpPrefix = "tcp://";
+    static constexpr const char* replayPrefix = "file:";
+    
+    virtual ~SerialTransport() = default;
+    
+    // Open the backend that matches portName (see above). Returns nullptr
+    // if the port can't be opened or the backend isn't available here.
+    static std::unique_ptr<SerialTransport> create(const juce::String& portName, const Options& options);
+    
+    // True for names that refer to an enumerable serial device rather than
+    // one of the virtual backends
+    static bool isDevicePortName(const juce::String& portName);
+    
+    // Copy up to maxBytes of received data. Returns the number of bytes
+    // read, 0 if nothing was waiting, or -1 if the connection is gone.
+    virtual int read(juce::uint8* buffer, int maxBytes) = 0;
+    
+    // Hand bytes to the driver. Returns the number accepted (0 if its
+    // buffer is full), or -1 if the connection is gone.
+    virtual int write(const juce::uint8* data, int numBytes) = 0;
+    
+    // Block until data is waiting, the timeout expires or wake() is called.
+    // Returns 1 if data is waiting, 0 on timeout/wake, -1 on error.
+    virtual int waitForData(int timeoutMs) = 0;
+    
+    // Interrupt a waitForData() on another thread
+    virtual void wake() = 0;
+    
+    // Block until write() can accept more bytes or the timeout expires
+    virtual bool waitForWritable(int timeoutMs) = 0;
+    
+    // Bytes buffered by the driver and not yet read
+    virtual int bytesAvailable() = 0;
+    
+    // Line rate actually in effect (the nominal rate for virtual backends)
+    virtual int getBaudRate() const = 0;
+    
+    virtual LowLatencyStatus getLowLatencyStatus() const { return {}; }
+    
+    // Path another program should open to talk to this transport (the pty
+    // slave device), empty if there isn't one
+    virtual juce::String getPeerPath() const { return {}; }
+};
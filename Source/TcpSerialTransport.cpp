@@ -0,0 +1,139 @@
+#include "TcpSerialTransport.h"
+
+// StreamingSocket can't be woken from another thread, so long waits are
+// sliced and the wake flag is checked in between
+static constexpr int waitSliceMs = 10;
+
+// waitUntilReady() try-locks the socket's read lock for reads and writes
+// alike and returns -1 if the other thread holds it, so -1 on a connected
+// socket means "busy, try again", not an error
+static constexpr int busyRetryMs = 1;
+
+// Kept short: the reconnect supervisor can't be stopped in the middle of
+// a connect, so a port change waits for it
+static constexpr int connectTimeoutMs = 1000;
+
+bool TcpSerialTransport::parseUrl(const juce::String& url, juce::String& host, int& port)
+{
+    if (! url.startsWithIgnoreCase(tcpPrefix))
+        return false;
+    
+    auto address = url.substring(juce::String(tcpPrefix).length());
+    host = address.upToLastOccurrenceOf(":", false, false);
+    port = address.fromLastOccurrenceOf(":", false, false).getIntValue();
+    
+    // [::1]:2000 style IPv6 literals
+    host = host.removeCharacters("[]");
+    
+    return host.isNotEmpty() && port > 0 && port < 65536;
+}
+
+std::unique_ptr<TcpSerialTransport> TcpSerialTransport::open(const juce::String& url, const Options& options)
+{
+    juce::String host;
+    int port = 0;
+    
+    if (! parseUrl(url, host, port))
+        return nullptr;
+    
+    // StreamingSocket turns Nagle off, so small MIDI writes go out at once
+    auto socket = std::make_unique<juce::StreamingSocket>();
+    
+    if (! socket->connect(host, port, connectTimeoutMs))
+        return nullptr;
+    
+    return std::unique_ptr<TcpSerialTransport>(new TcpSerialTransport(std::move(socket), options.baudRate));
+}
+
+TcpSerialTransport::TcpSerialTransport(std::unique_ptr<juce::StreamingSocket> s, int nominalBaud)
+    : socket(std::move(s)),
+      baudRate(nominalBaud)
+{
+}
+
+TcpSerialTransport::~TcpSerialTransport()
+{
+    socket->close();
+}
+
+int TcpSerialTransport::read(juce::uint8* buffer, int maxBytes)
+{
+    if (socket->waitUntilReady(true, 0) != 1)
+        return socket->isConnected() ? 0 : -1;
+    
+    const int result = socket->read(buffer, maxBytes, false);
+    
+    if (result > 0)
+        return result;
+    
+    // read() try-locks the same lock as the writer's wait, so nothing read
+    // only means the server closed the connection if the socket says so
+    return socket->isConnected() ? 0 : -1;
+}
+
+int TcpSerialTransport::write(const juce::uint8* data, int numBytes)
+{
+    const int result = socket->write(data, numBytes);
+    return result >= 0 ? result : -1;
+}
+
+int TcpSerialTransport::waitForData(int timeoutMs)
+{
+    const auto deadline = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(juce::jmax(0, timeoutMs));
+    
+    for (;;)
+    {
+        if (wakeRequested.exchange(false))
+            return 0;
+        
+        const auto now = juce::Time::getMillisecondCounter();
+        const int slice = now < deadline ? juce::jmin(waitSliceMs, static_cast<int>(deadline - now)) : 0;
+        const int ready = socket->waitUntilReady(true, slice);
+        
+        if (ready > 0)
+            return 1;
+        
+        if (ready < 0)
+        {
+            if (! socket->isConnected())
+                return -1;
+            
+            juce::Thread::sleep(busyRetryMs);
+        }
+        
+        if (juce::Time::getMillisecondCounter() >= deadline)
+            return 0;
+    }
+}
+
+void TcpSerialTransport::wake()
+{
+    wakeRequested = true;
+}
+
+bool TcpSerialTransport::waitForWritable(int timeoutMs)
+{
+    const auto deadline = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(juce::jmax(0, timeoutMs));
+    
+    for (;;)
+    {
+        const auto now = juce::Time::getMillisecondCounter();
+        // Sliced too, so the reader isn't locked out for the whole wait
+        const int slice = now < deadline ? juce::jmin(waitSliceMs, static_cast<int>(deadline - now)) : 0;
+        const int ready = socket->waitUntilReady(false, slice);
+        
+        if (ready > 0)
+            return true;
+        
+        if (ready < 0)
+        {
+            if (! socket->isConnected())
+                return false;
+            
+            juce::Thread::sleep(busyRetryMs);
+        }
+        
+        if (juce::Time::getMillisecondCounter() >= deadline)
+            return false;
+    }
+}
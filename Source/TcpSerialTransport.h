@@ -0,0 +1,37 @@
+#pragma once
+
+#include "SerialTransport.h"
+
+/**
+ * Raw TCP client for serial-over-network servers (ser2net, ESP-Link,
+ * socat ... TCP-LISTEN). Bytes pass through unchanged; there is no
+ * RFC 2217 negotiation, so the server sets the line rate.
+ */
+class TcpSerialTransport : public SerialTransport
+{
+public:
+    // Connect to "tcp://host:port"
+    static std::unique_ptr<TcpSerialTransport> open(const juce::String& url, const Options& options);
+    
+    // Split "tcp://host:port" into its parts; false if it doesn't parse
+    static bool parseUrl(const juce::String& url, juce::String& host, int& port);
+    
+    ~TcpSerialTransport() override;
+    
+    int read(juce::uint8* buffer, int maxBytes) override;
+    int write(const juce::uint8* data, int numBytes) override;
+    int waitForData(int timeoutMs) override;
+    void wake() override;
+    bool waitForWritable(int timeoutMs) override;
+    int bytesAvailable() override { return 0; }
+    int getBaudRate() const override { return baudRate; }
+    
+private:
+    TcpSerialTransport(std::unique_ptr<juce::StreamingSocket> socket, int nominalBaud);
+    
+    std::unique_ptr<juce::StreamingSocket> socket;
+    std::atomic<bool> wakeRequested { false };
+    int baudRate;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TcpSerialTransport)
+};
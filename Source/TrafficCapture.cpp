@@ -0,0 +1,366 @@
+#include "TrafficCapture.h"
+
+static_assert(sizeof(TrafficCapture::RecordHeader) == 16, "capture record header must stay 16 bytes");
+static_assert(sizeof(TrafficCapture::IndexEntry) == 16, "capture index entry must stay 16 bytes");
+static_assert(sizeof(TrafficCapture::FileHeader) <= TrafficCapture::dataOffset, "capture file header too big");
+
+constexpr char TrafficCapture::magic[8];
+
+//==============================================================================
+// Keeps the mapped window ahead of the writers
+class TrafficCapture::FlushThread : public juce::Thread
+{
+public:
+    explicit FlushThread(TrafficCapture& o)
+        : juce::Thread("Capture Flush"), owner(o)
+    {
+    }
+    
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            owner.segmentFull.wait(100);
+            owner.recycleFullSegments();
+        }
+    }
+    
+private:
+    TrafficCapture& owner;
+};
+
+//==============================================================================
+TrafficCapture::TrafficCapture()
+{
+}
+
+TrafficCapture::~TrafficCapture()
+{
+    stop();
+}
+
+bool TrafficCapture::start(const juce::File& file, juce::String& errorMessage, int segmentSizeBytes)
+{
+    stop();
+    
+    // Whole pages, and room for plenty of records per segment
+    segmentSize = (juce::jmax(65536, segmentSizeBytes) + 4095) & ~4095;
+    captureFile = file;
+    captureFile.deleteFile();
+    
+    fileStream = std::make_unique<juce::FileOutputStream>(captureFile);
+    
+    if (fileStream->failedToOpen())
+    {
+        errorMessage = fileStream->getStatus().getErrorMessage();
+        fileStream.reset();
+        return false;
+    }
+    
+    fileSize = 0;
+    startWallTimeMs = juce::Time::currentTimeMillis();
+    startTimeMs = juce::Time::getMillisecondCounterHiRes();
+    writeFileHeader(0, 0);
+    
+    oldestSegment = 0;
+    index.clearQuick();
+    nextIndexTimeUs = 0;
+    writePosition = 0;
+    recordsWritten = 0;
+    recordsDropped = 0;
+    segmentsFlushed = 0;
+    
+    for (int i = 0; i < numSegments; ++i)
+    {
+        if (! mapSegment(i))
+        {
+            errorMessage = "Couldn't map " + captureFile.getFullPathName();
+            closeFile();
+            return false;
+        }
+    }
+    
+    running = true;
+    flushThread = std::make_unique<FlushThread>(*this);
+    flushThread->startThread();
+    return true;
+}
+
+void TrafficCapture::stop()
+{
+    if (fileStream == nullptr)
+        return;
+    
+    // No new writes, then wait for the ones in flight
+    running = false;
+    
+    while (writers.load() > 0)
+        juce::Thread::yield();
+    
+    if (flushThread != nullptr)
+    {
+        flushThread->stopThread(2000);
+        flushThread.reset();
+    }
+    
+    recycleFullSegments();
+    
+    // Index whatever is in the segments still mapped
+    const juce::int64 dataBytes = writePosition.load();
+    
+    for (auto number = oldestSegment; number * segmentSize < dataBytes; ++number)
+    {
+        auto& segment = segments[number % numSegments];
+        
+        if (segment.number.load() == number && segment.data != nullptr)
+            indexRecords(segment.data, (int) juce::jmin((juce::int64) segmentSize, dataBytes - number * segmentSize),
+                         number * segmentSize);
+    }
+    
+    for (auto& segment : segments)
+    {
+        segment.number = -1;
+        segment.data = nullptr;
+        segment.map.reset();
+    }
+    
+    // Index straight after the data, then cut off the preallocated tail
+    const juce::int64 indexOffset = dataOffset + dataBytes;
+    fileStream->setPosition(indexOffset);
+    fileStream->write(index.getRawDataPointer(), (size_t) index.size() * sizeof(IndexEntry));
+    fileStream->flush();
+    fileStream->truncate();
+    
+    writeFileHeader(dataBytes, indexOffset);
+    closeFile();
+}
+
+bool TrafficCapture::write(Source source, Direction direction, double timeMs, const juce::uint8* data, int size)
+{
+    ++writers;
+    bool written = false;
+    
+    if (running.load() && size > 0)
+    {
+        RecordHeader header {};
+        header.timeUs = static_cast<juce::int64>((timeMs - startTimeMs) * 1000.0);
+        header.source = static_cast<juce::uint8>(source);
+        header.direction = static_cast<juce::uint8>(direction);
+        
+        written = writeRecords(header, data, size);
+    }
+    
+    --writers;
+    return written;
+}
+
+bool TrafficCapture::writeRecords(RecordHeader header, const juce::uint8* data, int size)
+{
+    // Anything too big to share a segment goes in pieces. All of them are
+    // reserved in one go, so a reader never sees a chain with its end missing.
+    const int maxPart = segmentSize / 4;
+    auto position = writePosition.load(std::memory_order_relaxed);
+    
+    for (;;)
+    {
+        // Lay the pieces out from here: one that doesn't fit in what is left
+        // of a segment starts the next, and the rest of that one is padding
+        juce::int64 end = position;
+        
+        for (int remaining = size; remaining > 0;)
+        {
+            const int part = juce::jmin(remaining, maxPart);
+            const int recordSize = (int) sizeof(RecordHeader) + part;
+            
+            if (end % segmentSize + recordSize > segmentSize)
+                end = (end / segmentSize + 1) * segmentSize;
+            
+            end += recordSize;
+            remaining -= part;
+        }
+        
+        for (auto number = position / segmentSize; number <= (end - 1) / segmentSize; ++number)
+        {
+            if (segments[number % numSegments].number.load(std::memory_order_acquire) != number)
+            {
+                // The flush thread hasn't mapped this far yet
+                recordsDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        
+        if (writePosition.compare_exchange_weak(position, end))
+            break;
+    }
+    
+    while (size > 0)
+    {
+        const int part = juce::jmin(size, maxPart);
+        const int recordSize = (int) sizeof(RecordHeader) + part;
+        size -= part;
+        
+        auto* segment = &segments[(position / segmentSize) % numSegments];
+        const int offset = (int) (position % segmentSize);
+        
+        if (offset + recordSize > segmentSize)
+        {
+            const int remaining = segmentSize - offset;
+            
+            if (remaining >= (int) sizeof(RecordHeader))
+            {
+                RecordHeader padding {};
+                padding.size = static_cast<juce::uint32>(remaining - (int) sizeof(RecordHeader));
+                padding.source = static_cast<juce::uint8>(Source::padding);
+                memcpy(segment->data + offset, &padding, sizeof(padding));
+            }
+            
+            finishWrite(*segment, remaining);
+            position += remaining;
+            segment = &segments[(position / segmentSize) % numSegments];
+        }
+        
+        header.size = static_cast<juce::uint32>(part);
+        header.flags = size > 0 ? continues : 0;
+        
+        juce::uint8* destination = segment->data + position % segmentSize;
+        memcpy(destination, &header, sizeof(header));
+        memcpy(destination + sizeof(header), data, (size_t) part);
+        finishWrite(*segment, recordSize);
+        recordsWritten.fetch_add(1, std::memory_order_relaxed);
+        
+        position += recordSize;
+        data += part;
+    }
+    
+    return true;
+}
+
+void TrafficCapture::finishWrite(Segment& segment, int numBytes)
+{
+    if (segment.bytesDone.fetch_add(numBytes, std::memory_order_acq_rel) + numBytes == segmentSize)
+        segmentFull.signal();
+}
+
+bool TrafficCapture::mapSegment(juce::int64 number)
+{
+    auto& segment = segments[number % numSegments];
+    const juce::int64 start = dataOffset + number * segmentSize;
+    const juce::int64 end = start + segmentSize;
+    
+    // Grow the file first: touching a mapping past the end would fault
+    if (fileSize < end)
+    {
+        fileStream->setPosition(end - 1);
+        fileStream->writeByte(0);
+        fileStream->flush();
+        fileSize = end;
+    }
+    
+    segment.map = std::make_unique<juce::MemoryMappedFile>(captureFile, juce::Range<juce::int64>(start, end),
+                                                           juce::MemoryMappedFile::readWrite);
+    
+    if (segment.map->getData() == nullptr || (int) segment.map->getSize() != segmentSize)
+    {
+        segment.map.reset();
+        segment.data = nullptr;
+        return false;
+    }
+    
+    // Fault every page in now, so writers never do
+    segment.data = static_cast<juce::uint8*>(segment.map->getData());
+    RealtimeThreading::prefault(segment.data, (size_t) segmentSize);
+    
+    segment.bytesDone = 0;
+    segment.number.store(number, std::memory_order_release);
+    return true;
+}
+
+void TrafficCapture::recycleFullSegments()
+{
+    for (;;)
+    {
+        auto& segment = segments[oldestSegment % numSegments];
+        
+        if (segment.number.load() != oldestSegment
+             || segment.bytesDone.load(std::memory_order_acquire) != segmentSize)
+            return;
+        
+        // Index it while it's still in memory; unmapping leaves the dirty
+        // pages to the kernel's writeback
+        indexRecords(segment.data, segmentSize, oldestSegment * segmentSize);
+        segment.data = nullptr;
+        segment.map.reset();
+        segmentsFlushed.fetch_add(1, std::memory_order_relaxed);
+        
+        const bool mapped = mapSegment(oldestSegment + numSegments);
+        ++oldestSegment;
+        
+        // Out of disk or address space: writers drop from here on
+        if (! mapped)
+            return;
+    }
+}
+
+void TrafficCapture::indexRecords(const juce::uint8* data, int numBytes, juce::int64 position)
+{
+    const juce::int64 intervalUs = indexIntervalMs * 1000;
+    int offset = 0;
+    
+    while (offset + (int) sizeof(RecordHeader) <= numBytes)
+    {
+        RecordHeader header;
+        memcpy(&header, data + offset, sizeof(header));
+        
+        if (header.source == static_cast<juce::uint8>(Source::endOfData))
+            break;
+        
+        if (header.source != static_cast<juce::uint8>(Source::padding) && header.timeUs >= nextIndexTimeUs)
+        {
+            index.add({ header.timeUs, position + offset });
+            nextIndexTimeUs = (header.timeUs / intervalUs + 1) * intervalUs;
+        }
+        
+        offset += (int) sizeof(header) + (int) header.size;
+    }
+}
+
+void TrafficCapture::writeFileHeader(juce::int64 dataBytes, juce::int64 indexOffset)
+{
+    FileHeader header {};
+    memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = version;
+    header.segmentSize = static_cast<juce::uint32>(segmentSize);
+    header.startWallTimeMs = startWallTimeMs;
+    header.startTimeMs = startTimeMs;
+    header.dataBytes = dataBytes;
+    header.indexOffset = indexOffset;
+    header.indexEntries = static_cast<juce::uint32>(index.size());
+    header.indexIntervalMs = indexIntervalMs;
+    
+    fileStream->setPosition(0);
+    fileStream->write(&header, sizeof(header));
+    fileStream->flush();
+    fileSize = juce::jmax(fileSize, (juce::int64) sizeof(header));
+}
+
+void TrafficCapture::closeFile()
+{
+    for (auto& segment : segments)
+    {
+        segment.number = -1;
+        segment.data = nullptr;
+        segment.map.reset();
+    }
+    
+    fileStream.reset();
+}
+
+TrafficCapture::Stats TrafficCapture::getStats() const
+{
+    Stats stats;
+    stats.recordsWritten = recordsWritten.load();
+    stats.recordsDropped = recordsDropped.load();
+    stats.bytesWritten = static_cast<juce::uint64>(writePosition.load());
+    stats.segmentsFlushed = segmentsFlushed.load();
+    return stats;
+}
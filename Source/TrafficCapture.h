@@ -0,0 +1,147 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "RealtimeThreading.h"
+
+/**
+ * TrafficCapture records everything that crosses the bridge (serial reads
+ * and writes, MIDI in and out) into a compact binary file.
+ *
+ * The file is written through a few memory-mapped segments that a
+ * background thread maps, grows and prefaults ahead of the writers, and
+ * unmaps (handing the pages to the kernel's writeback) once they are full.
+ * Writing a record is a compare-and-swap to reserve space plus a memcpy;
+ * it never blocks, allocates or makes a system call. If the flush thread
+ * falls a whole window behind, records are dropped and counted. A record
+ * split into pieces is written whole or dropped whole.
+ *
+ * Any number of threads may call write().
+ *
+ * File layout (native byte order):
+ *   FileHeader, padded to dataOffset
+ *   records: RecordHeader followed by size data bytes. Records never cross
+ *            a segment boundary; the end of a segment is filled with a
+ *            padding record, or left as zeros if less than a header fits.
+ *            A zero source marks the end of the data.
+ *   IndexEntry[indexEntries] at indexOffset: the first record at or after
+ *            each indexIntervalMs boundary, for seeking.
+ * dataBytes and the index are filled in by stop(); a capture that was never
+ * stopped can still be read by scanning the records.
+ */
+class TrafficCapture
+{
+public:
+    enum class Source : juce::uint8 { endOfData = 0, serial = 1, midi = 2, padding = 0xFF };
+    enum class Direction : juce::uint8 { in = 0, out = 1 };
+    
+    static constexpr juce::uint16 continues = 1;   // RecordHeader flag: split, the rest follows
+    
+    struct FileHeader
+    {
+        char magic[8];                  // "HMSCAP1"
+        juce::uint32 version;
+        juce::uint32 segmentSize;
+        juce::int64 startWallTimeMs;    // Time::currentTimeMillis() when capture started
+        double startTimeMs;             // getMillisecondCounterHiRes() of record time 0
+        juce::int64 dataBytes;          // 0 until stopped
+        juce::int64 indexOffset;        // file offset of the index
+        juce::uint32 indexEntries;
+        juce::uint32 indexIntervalMs;
+    };
+    
+    struct RecordHeader
+    {
+        juce::int64 timeUs;             // since FileHeader::startTimeMs
+        juce::uint32 size;              // data bytes that follow
+        juce::uint8 source;             // Source
+        juce::uint8 direction;          // Direction
+        juce::uint16 flags;
+    };
+    
+    struct IndexEntry
+    {
+        juce::int64 timeUs;
+        juce::int64 position;           // record offset from dataOffset
+    };
+    
+    static constexpr char magic[8] = "HMSCAP1";
+    static constexpr juce::uint32 version = 1;
+    static constexpr int dataOffset = 4096;
+    static constexpr int indexIntervalMs = 1000;
+    
+    struct Stats
+    {
+        juce::uint64 recordsWritten = 0;
+        juce::uint64 recordsDropped = 0;
+        juce::uint64 bytesWritten = 0;      // including record headers
+        juce::uint64 segmentsFlushed = 0;
+    };
+    
+    TrafficCapture();
+    ~TrafficCapture();
+    
+    // Create (or replace) the capture file and start recording
+    bool start(const juce::File& file, juce::String& errorMessage, int segmentSizeBytes = 1 << 20);
+    
+    // Stop recording, write the index and trim the file
+    void stop();
+    
+    bool isRunning() const { return running.load(std::memory_order_relaxed); }
+    const juce::File& getFile() const { return captureFile; }
+    
+    // getMillisecondCounterHiRes() time that records are stamped relative to
+    double getStartTimeMs() const { return startTimeMs; }
+    
+    // Record bytes seen at timeMs (getMillisecondCounterHiRes). Returns
+    // false if the record was dropped or capture isn't running.
+    bool write(Source source, Direction direction, double timeMs, const juce::uint8* data, int size);
+    
+    Stats getStats() const;
+    
+private:
+    class FlushThread;
+    
+    static constexpr int numSegments = 4;   // mapped window
+    
+    struct Segment
+    {
+        std::unique_ptr<juce::MemoryMappedFile> map;
+        juce::uint8* data = nullptr;
+        std::atomic<juce::int64> number { -1 };     // which segment of the file is mapped here
+        std::atomic<int> bytesDone { 0 };           // written or padded
+    };
+    
+    bool writeRecords(RecordHeader header, const juce::uint8* data, int size);
+    void finishWrite(Segment& segment, int numBytes);
+    
+    // Flush thread (and start/stop)
+    bool mapSegment(juce::int64 number);
+    void recycleFullSegments();
+    void indexRecords(const juce::uint8* data, int numBytes, juce::int64 position);
+    void writeFileHeader(juce::int64 dataBytes, juce::int64 indexOffset);
+    void closeFile();
+    
+    juce::File captureFile;
+    std::unique_ptr<juce::FileOutputStream> fileStream;
+    juce::int64 fileSize = 0;
+    int segmentSize = 0;
+    juce::int64 startWallTimeMs = 0;
+    double startTimeMs = 0.0;
+    
+    Segment segments[numSegments];
+    juce::int64 oldestSegment = 0;      // flush thread: next to fill up
+    juce::Array<IndexEntry> index;
+    juce::int64 nextIndexTimeUs = 0;
+    
+    std::atomic<bool> running { false };
+    std::atomic<int> writers { 0 };                 // threads inside write()
+    std::atomic<juce::int64> writePosition { 0 };   // bytes reserved, from dataOffset
+    juce::WaitableEvent segmentFull;
+    std::unique_ptr<FlushThread> flushThread;
+    
+    std::atomic<juce::uint64> recordsWritten { 0 };
+    std::atomic<juce::uint64> recordsDropped { 0 };
+    std::atomic<juce::uint64> segmentsFlushed { 0 };
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrafficCapture)
+};
@@ -0,0 +1,413 @@
+// MidiStreamParser tests
+//
+// The parser scans for status bytes a vector at a time and consumes data
+// bytes in runs. These tests hold it to the simple byte-at-a-time state
+// machine it replaced, on random streams cut into random reads, and check
+// that streamed SysEx comes back whole when real-time bytes interrupt it.
+
+#include <juce_core/juce_core.h>
+#include "MidiStreamParser.h"
+
+//==============================================================================
+// One byte at a time, the way the bridge parsed before the scanner: every
+// byte goes through the status/data state machine, real-time bytes go
+// straight out and leave the state alone
+class ReferenceParser
+{
+public:
+    explicit ReferenceParser(int maxSysExSizeToUse)
+        : maxSysExSize(maxSysExSizeToUse)
+    {
+    }
+
+    void parse(const juce::uint8* data, int numBytes)
+    {
+        for (int i = 0; i < numBytes; ++i)
+        {
+            const juce::uint8 byte = data[i];
+
+            if (MidiStreamParser::isRealtimeByte(byte))
+            {
+                ++stats.realtimeMessages;
+
+                if (onRealtimeMessage)
+                    onRealtimeMessage(byte);
+
+                continue;
+            }
+
+            if (byte & 0x80)
+                handleStatusByte(byte);
+            else
+                handleDataByte(byte);
+
+            if (dataExpected == 0)
+                emit();
+        }
+    }
+
+    MidiStreamParser::Stats stats;
+
+    std::function<void(const juce::uint8* data, int size)> onMessage;
+    std::function<void(juce::uint8 byte)> onRealtimeMessage;
+    std::function<void(const char* text, int length)> onDebugText;
+
+private:
+    enum class Pending { none, shortMessage, sysEx, debug };
+
+    void handleStatusByte(juce::uint8 byte)
+    {
+        if (byte == MidiStreamParser::MSG_SYSEX_END && pending == Pending::sysEx)
+        {
+            message.add(byte);
+            emit();
+            return;
+        }
+
+        if (dataExpected > 0)
+        {
+            ++stats.incompleteMessages;
+            emit();
+        }
+
+        if (byte >= 0x80 && byte <= 0xEF)
+            runningStatus = byte;
+        else if (byte <= MidiStreamParser::MSG_SYSEX_END)
+            runningStatus = 0;
+
+        dataExpected = MidiStreamParser::getDataLength(byte);
+
+        if (dataExpected < 0)
+        {
+            ++stats.unknownStatusBytes;
+            dataExpected = 0;
+        }
+
+        if (byte == MidiStreamParser::MSG_SYSEX_START)
+            pending = Pending::sysEx;
+        else if (byte == MidiStreamParser::MSG_DEBUG)
+            pending = Pending::debug;
+        else
+            pending = Pending::shortMessage;
+
+        message.clearQuick();
+        message.add(byte);
+    }
+
+    void handleDataByte(juce::uint8 byte)
+    {
+        if (dataExpected == 0 && runningStatus != 0)
+            handleStatusByte(runningStatus);
+
+        if (dataExpected == 0)
+        {
+            ++stats.unexpectedDataBytes;
+            return;
+        }
+
+        message.add(byte);
+        --dataExpected;
+
+        if (pending == Pending::debug && dataExpected == 0 && message.size() == 4)
+            dataExpected = message[3];
+    }
+
+    void emit()
+    {
+        switch (pending)
+        {
+            case Pending::none:
+                break;
+
+            case Pending::shortMessage:
+                ++stats.messages;
+                if (onMessage)
+                    onMessage(message.getRawDataPointer(), message.size());
+                break;
+
+            case Pending::sysEx:
+                if (message.size() > maxSysExSize)
+                {
+                    ++stats.sysExOverflows;
+                }
+                else
+                {
+                    ++stats.sysExMessages;
+                    if (onMessage)
+                        onMessage(message.getRawDataPointer(), message.size());
+                }
+                break;
+
+            case Pending::debug:
+                ++stats.debugMessages;
+                if (message.size() > 4 && onDebugText)
+                    onDebugText(reinterpret_cast<const char*>(message.getRawDataPointer() + 4), message.size() - 4);
+                break;
+        }
+
+        pending = Pending::none;
+        message.clearQuick();
+        dataExpected = 0;
+    }
+
+    int maxSysExSize;
+    Pending pending = Pending::none;
+    juce::Array<juce::uint8> message;
+    int dataExpected = 0;
+    juce::uint8 runningStatus = 0;
+};
+
+//==============================================================================
+// Every callback as a tagged record, so two parsers can be compared in order
+template <typename Parser>
+static void recordEvents(Parser& parser, juce::MemoryBlock& events)
+{
+    parser.onMessage = [&events](const juce::uint8* data, int size)
+    {
+        const juce::uint8 tag[] = { 'M', (juce::uint8) (size & 0xFF), (juce::uint8) (size >> 8) };
+        events.append(tag, sizeof(tag));
+        events.append(data, (size_t) size);
+    };
+
+    parser.onRealtimeMessage = [&events](juce::uint8 byte)
+    {
+        const juce::uint8 tag[] = { 'R', byte };
+        events.append(tag, sizeof(tag));
+    };
+
+    parser.onDebugText = [&events](const char* text, int length)
+    {
+        const juce::uint8 tag[] = { 'D', (juce::uint8) length };
+        events.append(tag, sizeof(tag));
+        events.append(text, (size_t) length);
+    };
+}
+
+class MidiStreamParserTests : public juce::UnitTest
+{
+public:
+    MidiStreamParserTests() : juce::UnitTest("MidiStreamParser", "Hairless") {}
+
+    void runTest() override
+    {
+        auto random = getRandom();
+
+        beginTest("Matches the byte-at-a-time parser on random streams");
+        {
+            for (int iteration = 0; iteration < 400; ++iteration)
+            {
+                const auto stream = makeRandomStream(random, iteration % numStreamKinds);
+                compareWithReference(stream, random);
+            }
+        }
+
+        beginTest("Streamed SysEx survives interleaved clock bytes");
+        {
+            for (int iteration = 0; iteration < 100; ++iteration)
+                checkStreamedSysEx(random);
+        }
+
+        beginTest("Whole SysEx survives interleaved clock bytes");
+        {
+            const juce::uint8 stream[] = { 0xF0, 0x7D, 0x01, 0xF8, 0x02, 0xF8, 0xF8, 0x03, 0xF7, 0x90, 0x3C, 0xF8, 0x64 };
+
+            MidiStreamParser parser;
+            juce::MemoryBlock events;
+            recordEvents(parser, events);
+            parser.parse(stream, (int) sizeof(stream));
+
+            const juce::uint8 expected[] = { 'R', 0xF8, 'R', 0xF8, 'R', 0xF8,
+                                             'M', 6, 0, 0xF0, 0x7D, 0x01, 0x02, 0x03, 0xF7,
+                                             'R', 0xF8,
+                                             'M', 3, 0, 0x90, 0x3C, 0x64 };
+
+            expect(events == juce::MemoryBlock(expected, sizeof(expected)));
+            expectEquals((int) parser.getStats().getErrorCount(), 0);
+        }
+    }
+
+private:
+    static constexpr int numStreamKinds = 5;
+
+    static juce::MemoryBlock makeRandomStream(juce::Random& random, int kind)
+    {
+        juce::MemoryBlock stream;
+        const int numBytes = random.nextInt(4000);
+
+        for (int i = 0; i < numBytes; ++i)
+        {
+            const int roll = random.nextInt(100);
+            juce::uint8 byte;
+
+            switch (kind)
+            {
+                case 0:     // noise: any byte at all
+                    byte = (juce::uint8) random.nextInt(256);
+                    break;
+
+                case 1:     // long running-status runs
+                    byte = roll < 3 ? (juce::uint8) (0x80 | random.nextInt(0x70)) : (juce::uint8) random.nextInt(128);
+                    break;
+
+                case 2:     // dense status bytes with clock in between
+                    byte = roll < 10 ? (juce::uint8) 0xF8
+                                     : roll < 35 ? (juce::uint8) (0x80 | random.nextInt(128)) : (juce::uint8) random.nextInt(128);
+                    break;
+
+                case 3:     // SysEx, some longer than the limit, interrupted by clock
+                    byte = roll < 2 ? MidiStreamParser::MSG_SYSEX_START
+                                    : roll < 4 ? MidiStreamParser::MSG_SYSEX_END
+                                               : roll < 7 ? (juce::uint8) 0xF8 : (juce::uint8) random.nextInt(128);
+                    break;
+
+                default:    // debug messages between notes
+                {
+                    if (roll < 5)
+                    {
+                        const int length = random.nextInt(20);
+                        const juce::uint8 header[] = { MidiStreamParser::MSG_DEBUG, 0, 0, (juce::uint8) length };
+                        stream.append(header, sizeof(header));
+
+                        for (int j = 0; j < length; ++j)
+                        {
+                            const juce::uint8 text = (juce::uint8) ('a' + random.nextInt(26));
+                            stream.append(&text, 1);
+                        }
+
+                        continue;
+                    }
+
+                    byte = roll < 30 ? (juce::uint8) (0x80 | random.nextInt(0x70)) : (juce::uint8) random.nextInt(128);
+                    break;
+                }
+            }
+
+            stream.append(&byte, 1);
+        }
+
+        return stream;
+    }
+
+    void compareWithReference(const juce::MemoryBlock& stream, juce::Random& random)
+    {
+        constexpr int maxSysExSize = 300;
+
+        MidiStreamParser parser;
+        parser.setMaxSysExSize(maxSysExSize);
+        ReferenceParser reference(maxSysExSize);
+
+        juce::MemoryBlock events, expectedEvents;
+        recordEvents(parser, events);
+        recordEvents(reference, expectedEvents);
+
+        const auto* data = static_cast<const juce::uint8*>(stream.getData());
+        const int size = (int) stream.getSize();
+
+        // Reads of any size, as a serial port hands them over
+        for (int offset = 0; offset < size;)
+        {
+            const int count = juce::jmin(size - offset, 1 + random.nextInt(100));
+            parser.parse(data + offset, count);
+            offset += count;
+        }
+
+        reference.parse(data, size);
+
+        expect(events == expectedEvents, "callbacks differ from the byte-at-a-time parser");
+
+        const auto stats = parser.getStats();
+        const auto& expected = reference.stats;
+        expectEquals((int) stats.messages, (int) expected.messages);
+        expectEquals((int) stats.sysExMessages, (int) expected.sysExMessages);
+        expectEquals((int) stats.realtimeMessages, (int) expected.realtimeMessages);
+        expectEquals((int) stats.debugMessages, (int) expected.debugMessages);
+        expectEquals((int) stats.incompleteMessages, (int) expected.incompleteMessages);
+        expectEquals((int) stats.unexpectedDataBytes, (int) expected.unexpectedDataBytes);
+        expectEquals((int) stats.unknownStatusBytes, (int) expected.unknownStatusBytes);
+        expectEquals((int) stats.sysExOverflows, (int) expected.sysExOverflows);
+        expectEquals((int) parser.getStreamPosition(), size);
+    }
+
+    void checkStreamedSysEx(juce::Random& random)
+    {
+        const int chunkSize = 8 + random.nextInt(120);
+
+        MidiStreamParser parser;
+        parser.setSysExStreaming(true, chunkSize);
+
+        // F0, payload with clock scattered through it, F7
+        juce::MemoryBlock stream, payload;
+        const int payloadSize = random.nextInt(2000);
+        int clocks = 0;
+
+        stream.append(&MidiStreamParser::MSG_SYSEX_START, 1);
+
+        for (int i = 0; i < payloadSize; ++i)
+        {
+            if (random.nextInt(10) == 0)
+            {
+                const juce::uint8 clock = 0xF8;
+                stream.append(&clock, 1);
+                ++clocks;
+            }
+
+            const juce::uint8 byte = (juce::uint8) random.nextInt(128);
+            stream.append(&byte, 1);
+            payload.append(&byte, 1);
+        }
+
+        stream.append(&MidiStreamParser::MSG_SYSEX_END, 1);
+
+        juce::MemoryBlock reassembled;
+        int chunks = 0, lastChunks = 0, realtimeSeen = 0;
+        bool chunkSizesOk = true;
+
+        parser.onSysExChunk = [&](const juce::uint8* data, int size, bool isLast)
+        {
+            // Only the first and last piece may be shorter than 4 bytes
+            if (size > chunkSize || (size < 4 && chunks > 0 && ! isLast))
+                chunkSizesOk = false;
+
+            reassembled.append(data, (size_t) size);
+            ++chunks;
+
+            if (isLast)
+                ++lastChunks;
+        };
+
+        parser.onRealtimeMessage = [&](juce::uint8 byte)
+        {
+            if (byte == 0xF8)
+                ++realtimeSeen;
+        };
+
+        parser.onMessage = [this](const juce::uint8*, int)
+        {
+            expect(false, "streamed SysEx delivered whole");
+        };
+
+        const auto* data = static_cast<const juce::uint8*>(stream.getData());
+        const int size = (int) stream.getSize();
+
+        for (int offset = 0; offset < size;)
+        {
+            const int count = juce::jmin(size - offset, 1 + random.nextInt(64));
+            parser.parse(data + offset, count);
+            offset += count;
+        }
+
+        juce::MemoryBlock expected;
+        expected.append(&MidiStreamParser::MSG_SYSEX_START, 1);
+        expected.append(payload.getData(), payload.getSize());
+        expected.append(&MidiStreamParser::MSG_SYSEX_END, 1);
+
+        expect(reassembled == expected, "chunks don't reassemble into the message");
+        expect(chunkSizesOk, "chunk outside the size limits");
+        expectEquals(lastChunks, 1);
+        expectEquals(realtimeSeen, clocks);
+        expectEquals((int) parser.getStats().sysExMessages, 1);
+        expectEquals((int) parser.getStats().getErrorCount(), 0);
+    }
+};
+
+static MidiStreamParserTests midiStreamParserTests;
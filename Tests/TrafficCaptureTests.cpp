@@ -0,0 +1,190 @@
+// TrafficCapture / CaptureReader tests
+//
+// Writes a capture with small segments, steering records so segment ends
+// get both a padding record and a gap too short for one, then reads it
+// back and checks every record comes out as written, and that a split
+// record that can't be written leaves no pieces behind.
+
+#include <juce_core/juce_core.h>
+#include "TrafficCapture.h"
+#include "CaptureReader.h"
+
+class TrafficCaptureTests : public juce::UnitTest
+{
+public:
+    TrafficCaptureTests() : juce::UnitTest("TrafficCapture", "Hairless") {}
+
+    void runTest() override
+    {
+        beginTest("Records round-trip through the capture file");
+        {
+            auto file = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                            .getNonexistentChildFile("hairless_capture_test", ".hmscap");
+
+            roundTrip(file);
+            file.deleteFile();
+        }
+    }
+
+private:
+    struct Written
+    {
+        TrafficCapture::Source source;
+        TrafficCapture::Direction direction;
+        juce::int64 timeUs;
+        juce::MemoryBlock data;
+    };
+
+    static constexpr int headerSize = (int) sizeof(TrafficCapture::RecordHeader);
+
+    void roundTrip(const juce::File& file)
+    {
+        // The smallest segment the capture allows, so the data spans
+        // several. Up to the deliberately oversized record, it all stays
+        // inside the mapped window, so nothing is dropped however far
+        // behind the flush thread is.
+        constexpr int segmentSize = 65536;
+
+        TrafficCapture capture;
+        juce::String error;
+
+        if (! capture.start(file, error, segmentSize))
+        {
+            expect(false, "couldn't start capture: " + error);
+            return;
+        }
+
+        juce::Array<Written> written;
+        juce::Random random(42);
+        juce::int64 position = 0;
+
+        auto write = [&](int size)
+        {
+            Written record;
+            record.source = random.nextBool() ? TrafficCapture::Source::serial : TrafficCapture::Source::midi;
+            record.direction = random.nextBool() ? TrafficCapture::Direction::in : TrafficCapture::Direction::out;
+            record.timeUs = written.size() * 250;
+
+            for (int i = 0; i < size; ++i)
+            {
+                const juce::uint8 byte = (juce::uint8) random.nextInt(256);
+                record.data.append(&byte, 1);
+            }
+
+            const double timeMs = capture.getStartTimeMs() + (double) record.timeUs * 0.001;
+            expect(capture.write(record.source, record.direction, timeMs,
+                                 static_cast<const juce::uint8*>(record.data.getData()), size));
+
+            // Mirror the writer: a record that doesn't fit starts the next segment
+            const int recordSize = headerSize + size;
+
+            if (position % segmentSize + recordSize > segmentSize)
+                position = (position / segmentSize + 1) * segmentSize;
+
+            position += recordSize;
+            written.add(record);
+        };
+
+        // Fill the rest of the current segment but leaveBytes
+        auto fillSegment = [&](int leaveBytes)
+        {
+            int remaining = segmentSize - (int) (position % segmentSize) - leaveBytes;
+
+            while (remaining > 0)
+            {
+                const int size = juce::jmin(remaining, segmentSize / 8) - headerSize;
+                write(juce::jmax(1, size));
+                remaining = segmentSize - (int) (position % segmentSize) - leaveBytes;
+            }
+        };
+
+        // Segment 0 ends with a gap too small for a header, segment 1 with
+        // a padding record, then random traffic into segment 2
+        fillSegment(headerSize / 2);
+        write(64);
+        fillSegment(headerSize + 40);
+        write(64);
+
+        while (position < 2 * segmentSize + segmentSize / 2)
+            write(1 + random.nextInt(600));
+
+        // Larger than a quarter segment: stored in pieces flagged continues
+        const int bigSize = segmentSize / 4 + 1000;
+        Written big;
+        big.source = TrafficCapture::Source::serial;
+        big.direction = TrafficCapture::Direction::in;
+        big.timeUs = written.size() * 250;
+
+        for (int i = 0; i < bigSize; ++i)
+        {
+            const juce::uint8 byte = (juce::uint8) (i * 7);
+            big.data.append(&byte, 1);
+        }
+
+        expect(capture.write(big.source, big.direction, capture.getStartTimeMs() + (double) big.timeUs * 0.001,
+                             static_cast<const juce::uint8*>(big.data.getData()), bigSize));
+
+        // Bigger than the mapped window: dropped whole, no pieces left behind
+        juce::HeapBlock<juce::uint8> huge((size_t) (5 * segmentSize), true);
+        expect(! capture.write(TrafficCapture::Source::serial, TrafficCapture::Direction::in,
+                               capture.getStartTimeMs(), huge, 5 * segmentSize));
+
+        capture.stop();
+
+        const auto stats = capture.getStats();
+        expectEquals((int) stats.recordsDropped, 1);
+
+        CaptureReader reader;
+
+        if (! reader.open(file, error))
+        {
+            expect(false, "couldn't open capture: " + error);
+            return;
+        }
+
+        expectEquals((int) reader.getHeader().segmentSize, segmentSize);
+        expect(reader.getHeader().dataBytes > 2 * segmentSize);
+        expect(reader.getHeader().indexEntries > 0);
+
+        CaptureReader::Record record;
+        int numRead = 0;
+        bool recordsMatch = true;
+
+        for (auto& expected : written)
+        {
+            if (! reader.next(record))
+                break;
+
+            ++numRead;
+
+            // Times go through a double, so allow a microsecond either way
+            if (record.source != expected.source || record.direction != expected.direction
+                 || record.flags != 0 || std::abs(record.timeUs - expected.timeUs) > 1
+                 || juce::MemoryBlock(record.data, (size_t) record.size) != expected.data)
+                recordsMatch = false;
+        }
+
+        expectEquals(numRead, written.size());
+        expect(recordsMatch, "a record read back differs from what was written");
+
+        // The big record, put back together from its pieces
+        juce::MemoryBlock reassembled;
+        int pieces = 0;
+
+        while (reader.next(record))
+        {
+            expect(record.is(big.source, big.direction));
+            reassembled.append(record.data, (size_t) record.size);
+            ++pieces;
+
+            if ((record.flags & TrafficCapture::continues) == 0)
+                break;
+        }
+
+        expectEquals(pieces, 2);
+        expect(reassembled == big.data, "split record doesn't reassemble");
+        expect(! reader.next(record), "records after the end of the data");
+    }
+};
+
+static TrafficCaptureTests trafficCaptureTests;
@@ -0,0 +1,248 @@
+// Serial device simulator
+//
+// Drives synthetic "Arduino" traffic into a serial device - normally the
+// pty loopback the bridge exposes when its serial port is set to "pty:" -
+// and counts whatever the bridge sends back. Plain POSIX so it builds and
+// runs on headless machines without JUCE.
+//
+//   hairless_device_sim --port /dev/pts/3 --rate 1000 --seconds 10 --pattern notes
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace
+{
+    struct Options
+    {
+        std::string port;
+        int messagesPerSecond = 1000;
+        double seconds = 5.0;
+        std::string pattern = "notes"; // notes | bend | sysex
+        bool runningStatus = false;
+        int channel = 0;
+    };
+
+    void printUsage(const char* argv0)
+    {
+        std::fprintf(stderr,
+            "Usage: %s --port <path> [--rate <msgs/s>] [--seconds <n>]\n"
+            "          [--pattern notes|bend|sysex] [--running-status] [--channel <1-16>]\n",
+            argv0);
+    }
+
+    bool parseArguments(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+
+            if (arg == "--port" && hasValue)
+                options.port = argv[++i];
+            else if (arg == "--rate" && hasValue)
+                options.messagesPerSecond = std::atoi(argv[++i]);
+            else if (arg == "--seconds" && hasValue)
+                options.seconds = std::atof(argv[++i]);
+            else if (arg == "--pattern" && hasValue)
+                options.pattern = argv[++i];
+            else if (arg == "--channel" && hasValue)
+                options.channel = std::atoi(argv[++i]) - 1;
+            else if (arg == "--running-status")
+                options.runningStatus = true;
+            else
+                return false;
+        }
+
+        return ! options.port.empty()
+            && options.messagesPerSecond > 0
+            && options.seconds > 0.0
+            && options.channel >= 0 && options.channel < 16
+            && (options.pattern == "notes" || options.pattern == "bend" || options.pattern == "sysex");
+    }
+
+    // Builds the next message of the chosen pattern into 'out'
+    class TrafficGenerator
+    {
+    public:
+        explicit TrafficGenerator(const Options& o) : options(o) {}
+
+        void next(std::vector<unsigned char>& out)
+        {
+            out.clear();
+
+            if (options.pattern == "sysex")
+            {
+                out.push_back(0xF0);
+                out.push_back(0x7D); // non-commercial ID
+                for (int i = 0; i < 32; ++i)
+                    out.push_back(static_cast<unsigned char>((counter + i) & 0x7F));
+                out.push_back(0xF7);
+                lastStatus = 0; // SysEx cancels running status
+            }
+            else if (options.pattern == "bend")
+            {
+                int value = (counter * 64) & 0x3FFF;
+                appendStatus(out, static_cast<unsigned char>(0xE0 | options.channel));
+                out.push_back(static_cast<unsigned char>(value & 0x7F));
+                out.push_back(static_cast<unsigned char>(value >> 7));
+            }
+            else
+            {
+                // Alternating note on / note off (velocity 0) across an octave
+                int note = 60 + (counter / 2) % 12;
+                bool on = (counter % 2) == 0;
+                appendStatus(out, static_cast<unsigned char>(0x90 | options.channel));
+                out.push_back(static_cast<unsigned char>(note));
+                out.push_back(static_cast<unsigned char>(on ? 100 : 0));
+            }
+
+            ++counter;
+        }
+
+    private:
+        void appendStatus(std::vector<unsigned char>& out, unsigned char status)
+        {
+            if (! options.runningStatus || status != lastStatus)
+                out.push_back(status);
+            lastStatus = status;
+        }
+
+        const Options& options;
+        int counter = 0;
+        unsigned char lastStatus = 0;
+    };
+
+    bool configureRaw(int fd)
+    {
+        struct termios tio;
+        if (tcgetattr(fd, &tio) != 0)
+            return false;
+
+        cfmakeraw(&tio);
+        return tcsetattr(fd, TCSANOW, &tio) == 0;
+    }
+
+    bool writeAll(int fd, const unsigned char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t n = ::write(fd, data, size);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                if (errno == EAGAIN)
+                {
+                    struct pollfd pfd = { fd, POLLOUT, 0 };
+                    poll(&pfd, 1, 100);
+                    continue;
+                }
+
+                return false;
+            }
+
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (! parseArguments(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    int fd = ::open(options.port.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0)
+    {
+        std::fprintf(stderr, "Cannot open %s: %s\n", options.port.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    if (! configureRaw(fd))
+        std::fprintf(stderr, "Warning: could not set raw mode on %s\n", options.port.c_str());
+
+    std::atomic<bool> running { true };
+    std::atomic<long long> bytesReceived { 0 };
+
+    // Count whatever the bridge sends back (MIDI input -> serial direction)
+    std::thread reader([&]()
+    {
+        unsigned char buffer[1024];
+
+        while (running.load())
+        {
+            struct pollfd pfd = { fd, POLLIN, 0 };
+            if (poll(&pfd, 1, 50) <= 0)
+                continue;
+
+            ssize_t n = ::read(fd, buffer, sizeof(buffer));
+            if (n > 0)
+                bytesReceived += n;
+        }
+    });
+
+    using Clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::duration<double>(1.0 / options.messagesPerSecond);
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+
+    TrafficGenerator generator(options);
+    std::vector<unsigned char> message;
+    long long messagesSent = 0;
+    long long bytesSent = 0;
+    bool writeFailed = false;
+
+    auto nextSend = start;
+    while (Clock::now() < end)
+    {
+        generator.next(message);
+
+        if (! writeAll(fd, message.data(), message.size()))
+        {
+            std::fprintf(stderr, "Write failed: %s\n", std::strerror(errno));
+            writeFailed = true;
+            break;
+        }
+
+        ++messagesSent;
+        bytesSent += static_cast<long long>(message.size());
+
+        nextSend += std::chrono::duration_cast<Clock::duration>(interval);
+        std::this_thread::sleep_until(nextSend);
+    }
+
+    // Give the bridge a moment to echo anything still in flight
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    running = false;
+    reader.join();
+    ::close(fd);
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::printf("pattern        %s%s\n", options.pattern.c_str(), options.runningStatus ? " (running status)" : "");
+    std::printf("messages sent  %lld (%.1f msg/s)\n", messagesSent, messagesSent / elapsed);
+    std::printf("bytes sent     %lld (%.1f B/s)\n", bytesSent, bytesSent / elapsed);
+    std::printf("bytes received %lld\n", bytesReceived.load());
+
+    return writeFailed ? 1 : 0;
+}